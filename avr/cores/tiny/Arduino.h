@@ -125,7 +125,17 @@ unsigned long pulseIn(uint8_t pin, uint8_t state, unsigned long timeout);
 #ifndef NO_MILLIS
 unsigned long pulseInLong(uint8_t pin, uint8_t state, unsigned long timeout);
 #endif
+#if defined(ICR1)
+// Pulse measurement on the ICP1 pin with the Timer1 input capture unit, see
+// wiring_pulse_capture.c.  Timer1 can't be used for anything else meanwhile.
+unsigned long pulseInCapture(uint8_t state, unsigned long timeout);
+void pulseInNonBlocking(uint8_t state, uint16_t *train, uint8_t count);
+uint8_t pulseInAvailable(void);
+unsigned long pulseInResult(void);
+void pulseInStop(void);
+#endif
 void shiftOut(uint8_t dataPin, uint8_t clockPin, uint8_t bitOrder, uint8_t val);
+void shiftOutBuffer(uint8_t dataPin, uint8_t clockPin, uint8_t bitOrder, const uint8_t *buffer, uint16_t length);
 uint8_t shiftIn(uint8_t dataPin, uint8_t clockPin, uint8_t bitOrder);
 
 void attachInterrupt(uint8_t, void (*)(void), int mode);
@@ -418,6 +428,207 @@ static inline uint8_t digitalRead(uint8_t pin)
 }
 #endif
 
+// Pin change interrupts with a callback per pin, like attachInterrupt() but
+// on any pin with a PCINT.  Each port's dispatcher (and its ISR) is only
+// linked in if a pin on that port is attached, see WInterrupts_pcint.h.
+#if defined(PCINT_PORT0_PCMSK)
+void _attachPinChangeInterrupt0(uint8_t bit, void (*func)(void), uint8_t mode);
+void _detachPinChangeInterrupt0(uint8_t bit);
+#endif
+#if defined(PCINT_PORT1_PCMSK)
+void _attachPinChangeInterrupt1(uint8_t bit, void (*func)(void), uint8_t mode);
+void _detachPinChangeInterrupt1(uint8_t bit);
+#endif
+#if defined(PCINT_PORT2_PCMSK)
+void _attachPinChangeInterrupt2(uint8_t bit, void (*func)(void), uint8_t mode);
+void _detachPinChangeInterrupt2(uint8_t bit);
+#endif
+#if defined(PCINT_PORT3_PCMSK)
+void _attachPinChangeInterrupt3(uint8_t bit, void (*func)(void), uint8_t mode);
+void _detachPinChangeInterrupt3(uint8_t bit);
+#endif
+
+#if defined(PCINT_PORT0_PCMSK)
+static inline void attachPinChangeInterrupt(uint8_t, void (*)(void), uint8_t) __attribute__((always_inline, unused));
+static inline void attachPinChangeInterrupt(uint8_t pin, void (*func)(void), uint8_t mode)
+{
+  if( pin & 0b10000000 )
+  {
+    pin = analogInputToDigitalPin( pin & 0b01111111 );
+  }
+
+  volatile uint8_t *pcmsk = digitalPinToPCMSK(pin);
+  uint8_t bit = digitalPinToPCMSKbit(pin);
+
+  if (pcmsk == &PCINT_PORT0_PCMSK) _attachPinChangeInterrupt0(bit, func, mode);
+  #if defined(PCINT_PORT1_PCMSK)
+  else if (pcmsk == &PCINT_PORT1_PCMSK) _attachPinChangeInterrupt1(bit, func, mode);
+  #endif
+  #if defined(PCINT_PORT2_PCMSK)
+  else if (pcmsk == &PCINT_PORT2_PCMSK) _attachPinChangeInterrupt2(bit, func, mode);
+  #endif
+  #if defined(PCINT_PORT3_PCMSK)
+  else if (pcmsk == &PCINT_PORT3_PCMSK) _attachPinChangeInterrupt3(bit, func, mode);
+  #endif
+  else return; // Not a PCINT pin
+
+  *digitalPinToPCICR(pin) |= _BV(digitalPinToPCICRbit(pin));
+}
+
+// Leaves the PCIE bit alone, other pins on the port may still be attached
+static inline void detachPinChangeInterrupt(uint8_t) __attribute__((always_inline, unused));
+static inline void detachPinChangeInterrupt(uint8_t pin)
+{
+  if( pin & 0b10000000 )
+  {
+    pin = analogInputToDigitalPin( pin & 0b01111111 );
+  }
+
+  volatile uint8_t *pcmsk = digitalPinToPCMSK(pin);
+  uint8_t bit = digitalPinToPCMSKbit(pin);
+
+  if (pcmsk == &PCINT_PORT0_PCMSK) _detachPinChangeInterrupt0(bit);
+  #if defined(PCINT_PORT1_PCMSK)
+  else if (pcmsk == &PCINT_PORT1_PCMSK) _detachPinChangeInterrupt1(bit);
+  #endif
+  #if defined(PCINT_PORT2_PCMSK)
+  else if (pcmsk == &PCINT_PORT2_PCMSK) _detachPinChangeInterrupt2(bit);
+  #endif
+  #if defined(PCINT_PORT3_PCMSK)
+  else if (pcmsk == &PCINT_PORT3_PCMSK) _detachPinChangeInterrupt3(bit);
+  #endif
+}
+#endif
+
+// Some parts call the external interrupt vectors EXT_INTn_vect, not INTn_vect.
+#if defined( EXT_INT0_vect )
+  #define EXTERNAL_INTERRUPT_0_vect EXT_INT0_vect
+#elif defined( INT0_vect )
+  #define EXTERNAL_INTERRUPT_0_vect INT0_vect
+#endif
+
+#if defined( EXT_INT1_vect )
+  #define EXTERNAL_INTERRUPT_1_vect EXT_INT1_vect
+#elif defined( INT1_vect )
+  #define EXTERNAL_INTERRUPT_1_vect INT1_vect
+#endif
+
+#if defined( EXT_INT2_vect )
+  #define EXTERNAL_INTERRUPT_2_vect EXT_INT2_vect
+#elif defined( INT2_vect )
+  #define EXTERNAL_INTERRUPT_2_vect INT2_vect
+#endif
+
+#if defined( EXT_INT3_vect )
+  #define EXTERNAL_INTERRUPT_3_vect EXT_INT3_vect
+#elif defined( INT3_vect )
+  #define EXTERNAL_INTERRUPT_3_vect INT3_vect
+#endif
+
+#if defined( EXT_INT4_vect )
+  #define EXTERNAL_INTERRUPT_4_vect EXT_INT4_vect
+#elif defined( INT4_vect )
+  #define EXTERNAL_INTERRUPT_4_vect INT4_vect
+#endif
+
+#if defined( EXT_INT5_vect )
+  #define EXTERNAL_INTERRUPT_5_vect EXT_INT5_vect
+#elif defined( INT5_vect )
+  #define EXTERNAL_INTERRUPT_5_vect INT5_vect
+#endif
+
+#if defined( EXT_INT6_vect )
+  #define EXTERNAL_INTERRUPT_6_vect EXT_INT6_vect
+#elif defined( INT6_vect )
+  #define EXTERNAL_INTERRUPT_6_vect INT6_vect
+#endif
+
+#if defined( EXT_INT7_vect )
+  #define EXTERNAL_INTERRUPT_7_vect EXT_INT7_vect
+#elif defined( INT7_vect )
+  #define EXTERNAL_INTERRUPT_7_vect INT7_vect
+#endif
+
+#if defined( EXT_INT8_vect )
+  #define EXTERNAL_INTERRUPT_8_vect EXT_INT8_vect
+#elif defined( INT8_vect )
+  #define EXTERNAL_INTERRUPT_8_vect INT8_vect
+#endif
+
+#if defined( EXT_INT9_vect )
+  #define EXTERNAL_INTERRUPT_9_vect EXT_INT9_vect
+#elif defined( INT9_vect )
+  #define EXTERNAL_INTERRUPT_9_vect INT9_vect
+#endif
+
+// External interrupts with the handler bound at compile time.  attachInterrupt()
+// calls through a function pointer, so the ISR has to save every call-clobbered
+// register before the handler even starts; with
+//
+//   void onEdge() { ... }
+//   FAST_INTERRUPT(0, onEdge)
+//
+// at file scope, onEdge() is inlined into the INT0 vector itself and only the
+// registers it actually uses are saved.  Any ISR() flags can follow the
+// handler, e.g. FAST_INTERRUPT(1, onEdge, ISR_NOBLOCK) - with ISR_NAKED the
+// handler has to save SREG and its registers and end in reti() itself.
+// Then enableFastInterrupt(0, RISING) sets the mode and turns it on.  The
+// vector is the same one attachInterrupt() uses, so a sketch can't use both.
+#define FAST_INTERRUPT(num, handler, ...) \
+  ISR(EXTERNAL_INTERRUPT_ ## num ## _vect, ##__VA_ARGS__) { handler(); }
+
+#if defined(INT0)
+#if defined(EICRA)
+  #define _EXT_INT_CONTROL EICRA
+#else
+  #define _EXT_INT_CONTROL MCUCR
+#endif
+#if defined(EIMSK)
+  #define _EXT_INT_MASK EIMSK
+#else
+  #define _EXT_INT_MASK GIMSK
+#endif
+#if defined(EIFR)
+  #define _EXT_INT_FLAGS EIFR
+#else
+  #define _EXT_INT_FLAGS GIFR
+#endif
+
+static inline void enableFastInterrupt(uint8_t, uint8_t) __attribute__((always_inline, unused));
+static inline void enableFastInterrupt(uint8_t num, uint8_t mode)
+{
+  #if defined(INT1)
+  if (num == 1) {
+    #if defined(ISC11)
+    _EXT_INT_CONTROL = (_EXT_INT_CONTROL & ~(_BV(ISC10) | _BV(ISC11))) | (mode << ISC10);
+    #else
+    // The x61 has one set of sense control bits for both
+    _EXT_INT_CONTROL = (_EXT_INT_CONTROL & ~(_BV(ISC00) | _BV(ISC01))) | (mode << ISC00);
+    #endif
+    // Changing the mode can set the flag, don't take that as an edge
+    _EXT_INT_FLAGS = _BV(INTF1);
+    _EXT_INT_MASK |= _BV(INT1);
+    return;
+  }
+  #endif
+  _EXT_INT_CONTROL = (_EXT_INT_CONTROL & ~(_BV(ISC00) | _BV(ISC01))) | (mode << ISC00);
+  _EXT_INT_FLAGS = _BV(INTF0);
+  _EXT_INT_MASK |= _BV(INT0);
+}
+
+static inline void disableFastInterrupt(uint8_t) __attribute__((always_inline, unused));
+static inline void disableFastInterrupt(uint8_t num)
+{
+  #if defined(INT1)
+  if (num == 1) {
+    _EXT_INT_MASK &= ~_BV(INT1);
+    return;
+  }
+  #endif
+  _EXT_INT_MASK &= ~_BV(INT0);
+}
+#endif
+
 uint16_t _analogRead(uint8_t pin);
 #ifndef analogRead
 // analogRead() is almost always going to be getting a constant pin
@@ -443,6 +654,70 @@ static inline uint16_t analogRead(uint8_t pin)
 }
 #endif
 
+/*=============================================================================
+ * Interrupt driven ADC scanning, so that reading several sensors does not
+ * stall the sketch for the ~100us of every conversion.
+ *
+ * analogScanBegin(channels, count, mode) converts each channel in the list
+ *   in turn from the ADC interrupt.  Channels are the same numbers analogRead()
+ *   takes (A0..An, or the raw MUX numbers of the differential channels,
+ *   ADC_TEMPERATURE, ADC_HIGH_GAIN(x) on the x61...).  The list is NOT copied,
+ *   it has to stay put until the scan is over.  mode is ANALOG_SCAN_ONCE (go
+ *   through the list once) or ANALOG_SCAN_CONTINUOUS (start again at the top
+ *   until analogScanEnd()).
+ *
+ * Results are kept in a small ring buffer (ANALOG_SCAN_BUFFER_SIZE - 1 of
+ *   them, new ones are dropped if it is full), analogScanRead(&index) returns
+ *   the oldest result, -1 if there is none, and the position in the list of
+ *   the channel it came from.  Alternatively analogScanAttach(callback) has
+ *   callback(index, value) called from the interrupt with each result instead.
+ *
+ * Don't call analogRead() while a scan is running.  The first conversion after
+ *   switching to a differential channel or another reference may be off, list
+ *   the channel twice and ignore the first if that matters.
+ *===========================================================================*/
+#define ANALOG_SCAN_ONCE        1
+#define ANALOG_SCAN_CONTINUOUS  2
+
+typedef void (*analogScanCallback)(uint8_t index, uint16_t value);
+
+void    analogScanBegin(const uint8_t *channels, uint8_t count, uint8_t mode);
+void    analogScanEnd(void);
+uint8_t analogScanRunning(void);
+uint8_t analogScanAvailable(void);
+int     analogScanRead(uint8_t *index);
+void    analogScanAttach(analogScanCallback callback);
+
+/*=============================================================================
+ * Quieter and higher resolution analogRead()
+ *
+ * analogReadNoiseReduced(pin) does the conversion in ADC Noise Reduction
+ *   sleep, which stops the CPU and the I/O clock while it runs.  That also
+ *   stops timer0, so millis() falls behind by the length of each conversion,
+ *   and it needs the ADC interrupt (see the scanner above, don't call it while
+ *   a scan is running).
+ *
+ * analogReadOversampled(pin, bits) returns an 11 to 16 bit result (10 or less
+ *   is just analogRead()) by summing 4^(bits - 10) conversions, ie 4 for 11
+ *   bits up to 4096 for 16, and decimating.  The signal needs an LSB or so of
+ *   noise on it for this to gain anything, so analogReadOversampledNoiseReduced()
+ *   which does the same with noise reduced conversions will often gain less.
+ *===========================================================================*/
+uint16_t analogReadNoiseReduced(uint8_t pin);
+uint16_t _analogOversample(uint8_t pin, uint8_t bits, uint16_t (*convert)(uint8_t));
+
+static inline uint16_t analogReadOversampled(uint8_t, uint8_t) __attribute__((always_inline, unused));
+static inline uint16_t analogReadOversampled(uint8_t pin, uint8_t bits)
+{
+  return _analogOversample(pin & 0b01111111, bits, _analogRead);
+}
+
+static inline uint16_t analogReadOversampledNoiseReduced(uint8_t, uint8_t) __attribute__((always_inline, unused));
+static inline uint16_t analogReadOversampledNoiseReduced(uint8_t pin, uint8_t bits)
+{
+  return _analogOversample(pin & 0b01111111, bits, analogReadNoiseReduced);
+}
+
 #ifndef USE_NEW_MILLIS
 #ifndef NO_MILLIS
 unsigned long millis(void);
@@ -549,6 +824,11 @@ void delayMicroseconds(unsigned int us);
   #include "HardwareSerial.h"
 #elif USE_SERIAL_TYPE == SERIAL_TYPE_SOFTWARE
   #include "TinySoftwareSerial.h"
+  // The interrupt driven software serial transmit needs Timer1, which is
+  // otherwise the tone timer
+  #if SERIAL_TX_BUFFER_SIZE && (TIMER_TO_USE_FOR_TONE == 1) && !defined(NO_TONE)
+    #define NO_TONE
+  #endif
 #elif USE_SERIAL_TYPE == SERIAL_TYPE_HALF_DUPLEX
   #include "HalfDuplexSerial.h"
 #endif
@@ -562,11 +842,23 @@ unsigned long pulseIn(uint8_t pin, uint8_t state, unsigned long timeout = 100000
 #ifndef NO_MILLIS
 unsigned long pulseInLong(uint8_t pin, uint8_t state, unsigned long timeout = 1000000L);
 #endif
+#if defined(ICR1)
+unsigned long pulseInCapture(uint8_t state, unsigned long timeout = 1000000L);
+void pulseInNonBlocking(uint8_t state, uint16_t *train = NULL, uint8_t count = 1);
+#endif
 
 #if !defined(tone) && !defined(NO_TONE)
 void initToneTimer(void);
 void tone(uint8_t _pin, unsigned long frequency, unsigned long duration = 0);
 void noTone(uint8_t _pin = 255);
+// Notes by MIDI number (60 is middle C), and a queue of notes played one
+// after the other from the tone interrupt; a frequency of 0 (or a note out of
+// the table's C2-B7 range) is a rest.  toneQueue() returns false if the queue
+// is full, or a tone is already playing on another pin.
+void toneNote(uint8_t _pin, uint8_t note, unsigned long duration = 0);
+bool toneQueue(uint8_t _pin, unsigned long frequency, unsigned long duration);
+bool toneQueueNote(uint8_t _pin, uint8_t note, unsigned long duration);
+uint8_t toneQueueRoom(void);
 #endif
 
 // WMath prototypes
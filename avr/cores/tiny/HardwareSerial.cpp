@@ -35,45 +35,47 @@
 
 #include "HardwareSerial.h"
 
-// Define constants and variables for buffering incoming serial data.  We're
-// using a ring buffer (I think), in which rx_buffer_head is the index of the
-// location to which to write the next incoming character and rx_buffer_tail
-// is the index of the location from which to read.
-#if (RAMEND < 1000)
-  #define SERIAL_BUFFER_SIZE 16
-#else
-  #define SERIAL_BUFFER_SIZE 64
-#endif
-
-struct ring_buffer
-{
-  unsigned char buffer[SERIAL_BUFFER_SIZE];
-  byte head;
-  byte tail;
-};
-
+// The receive ISRs put() into rx_buffer and the sketch get()s from it, the
+// other way round for tx_buffer, see RingBuffer.h.  If rx_buffer is full the
+// incoming character is dropped.  With SERIAL_TX_BUFFER_SIZE 0 there is no
+// tx_buffer and no data register empty interrupt, write() does it all.
 #if defined(UBRRH) || defined(UBRR0H) || defined(LINCR)
-  ring_buffer rx_buffer  =  { { 0 }, 0, 0 };
-  ring_buffer tx_buffer  =  { { 0 }, 0, 0 };
+  rx_ring_buffer rx_buffer;
+  #if SERIAL_TX_BUFFER_SIZE
+  tx_ring_buffer tx_buffer;
+  #endif
 #endif
 #if defined(UBRR1H)
-  ring_buffer rx_buffer1  =  { { 0 }, 0, 0 };
-  ring_buffer tx_buffer1  =  { { 0 }, 0, 0 };
+  rx_ring_buffer rx_buffer1;
+  #if SERIAL_TX_BUFFER_SIZE
+  tx_ring_buffer tx_buffer1;
+  #endif
 #endif
 
-inline void store_char(unsigned char c, ring_buffer *buffer)
+#if SERIAL_TX_BUFFER_SIZE
+// The next byte for the transmit interrupt: what is left of a frame from
+// writeFrame() first, then the ring buffer, -1 if there is nothing to send.
+// Bit 8 is set on the last byte of a frame, the caller calls tx_frame_sent()
+// once that byte is in the data register.
+static inline int next_tx_byte(HardwareSerial &port, tx_ring_buffer &ring)
 {
-  byte i = (buffer->head + 1) % SERIAL_BUFFER_SIZE;
-
-  // if we should be storing the received character into the location
-  // just before the tail (meaning that the head would advance to the
-  // current location of the tail), we're about to overflow the buffer
-  // and so we don't write the character or advance the head.
-  if (i != buffer->tail) {
-    buffer->buffer[buffer->head] = c;
-    buffer->head = i;
+  uint16_t left = port._frame_left;
+  if (left) {
+    const uint8_t *p = port._frame_data;
+    uint8_t c = *p;
+    port._frame_data = p + 1;
+    port._frame_left = --left;
+    return left ? c : (c | 0x100);
   }
+  return ring.get();
+}
+
+static inline void tx_frame_sent(HardwareSerial &port)
+{
+  void (*done)(void) = port._frame_done;
+  if (done) done();
 }
+#endif
 
 #if defined(USART_RX_vect)
   ISR(USART_RX_vect)
@@ -85,7 +87,7 @@ inline void store_char(unsigned char c, ring_buffer *buffer)
   #else
     #error UDR not defined
   #endif
-    store_char(c, &rx_buffer);
+    rx_buffer.put(c);
   }
 #elif defined(USART0_RX_vect)
   ISR(USART0_RX_vect)
@@ -97,7 +99,7 @@ inline void store_char(unsigned char c, ring_buffer *buffer)
   #else
     #error UDR not defined
   #endif
-    store_char(c, &rx_buffer);
+    rx_buffer.put(c);
   }
 #elif defined(UART_RX_vect)
   ISR(UART_RX_vect)
@@ -109,7 +111,7 @@ inline void store_char(unsigned char c, ring_buffer *buffer)
   #else
     #error UDR not defined
   #endif
-    store_char(c, &rx_buffer);
+    rx_buffer.put(c);
   }
 #elif defined(UART0_RX_vect)
   ISR(UART0_RX_vect)
@@ -121,7 +123,7 @@ inline void store_char(unsigned char c, ring_buffer *buffer)
   #else
     #error UDR not defined
   #endif
-    store_char(c, &rx_buffer);
+    rx_buffer.put(c);
   }
 #elif defined(LIN_TC_vect)
   // this is for attinyX7
@@ -129,19 +131,18 @@ inline void store_char(unsigned char c, ring_buffer *buffer)
   {
     if(LINSIR & _BV(LRXOK)) {
         unsigned char c  =  LINDAT;
-        store_char(c, &rx_buffer);
+        rx_buffer.put(c);
     }
     if(LINSIR & _BV(LTXOK)){
       //PINA |= _BV(PINA5); //debug
-      if (tx_buffer.head == tx_buffer.tail) {
+      int c = next_tx_byte(Serial, tx_buffer);
+      if (c < 0) {
       // Buffer empty, so disable interrupts
         cbi(LINENIR,LENTXOK);
       } else {
         // There is more data in the output buffer. Send the next byte
-        unsigned char c = tx_buffer.buffer[tx_buffer.tail];
-        tx_buffer.tail = (tx_buffer.tail + 1) % SERIAL_BUFFER_SIZE;
-
         LINDAT = c;
+        if (c & 0x100) tx_frame_sent(Serial);
       }
     }
   }
@@ -154,18 +155,19 @@ inline void store_char(unsigned char c, ring_buffer *buffer)
   ISR(USART1_RX_vect)
   {
     unsigned char c = UDR1;
-    store_char(c, &rx_buffer1);
+    rx_buffer1.put(c);
   }
 #elif defined(USART1_RXC_vect)
   ISR(USART1_RXC_vect )
   {
     unsigned char c = UDR1;
-    store_char(c, &rx_buffer1);
+    rx_buffer1.put(c);
   }
 #else
   //no UART1
 #endif
 
+#if SERIAL_TX_BUFFER_SIZE
 #if !defined(UART0_UDRE_vect) && !defined(UART_UDRE_vect) && !defined(USART0_UDRE_vect) && !defined(USART_UDRE_vect) && !defined(LIN_TC_vect)
   #error "Don't know what the Data Register Empty vector is called for the first UART"
 #else
@@ -180,7 +182,8 @@ ISR(USART_UDRE_vect)
 #endif
 #if !defined(LIN_TC_vect)
 {
-  if (tx_buffer.head == tx_buffer.tail) {
+  int c = next_tx_byte(Serial, tx_buffer);
+  if (c < 0) {
   // Buffer empty, so disable interrupts
 #if defined(UCSR0B)
     cbi(UCSR0B, UDRIE0);
@@ -189,9 +192,6 @@ ISR(USART_UDRE_vect)
 #endif
   } else {
     // There is more data in the output buffer. Send the next byte
-    unsigned char c = tx_buffer.buffer[tx_buffer.tail];
-    tx_buffer.tail = (tx_buffer.tail + 1) % SERIAL_BUFFER_SIZE;
-
   #if defined(UDR)
     UDR = c;
   #elif defined(UDR0)
@@ -199,6 +199,7 @@ ISR(USART_UDRE_vect)
   #else
     #error UDR not defined
   #endif
+    if (c & 0x100) tx_frame_sent(Serial);
   }
 }
 #endif
@@ -207,24 +208,27 @@ ISR(USART_UDRE_vect)
 #ifdef USART1_UDRE_vect
 ISR(USART1_UDRE_vect)
 {
-  if (tx_buffer1.head == tx_buffer1.tail) {
+  int c = next_tx_byte(Serial1, tx_buffer1);
+  if (c < 0) {
   // Buffer empty, so disable interrupts
     cbi(UCSR1B, UDRIE1);
   }
   else {
     // There is more data in the output buffer. Send the next byte
-    unsigned char c = tx_buffer1.buffer[tx_buffer1.tail];
-    tx_buffer1.tail = (tx_buffer1.tail + 1) % SERIAL_BUFFER_SIZE;
-
     UDR1 = c;
+    if (c & 0x100) tx_frame_sent(Serial1);
   }
 }
 #endif
+#endif // SERIAL_TX_BUFFER_SIZE
 
 
 // Constructors ////////////////////////////////////////////////////////////////
 
-HardwareSerial::HardwareSerial(ring_buffer *rx_buffer, ring_buffer *tx_buffer
+HardwareSerial::HardwareSerial(rx_ring_buffer *rx_buffer
+#if SERIAL_TX_BUFFER_SIZE
+  , tx_ring_buffer *tx_buffer
+#endif
 #if ( defined(UBRRH) || defined(UBRR0H) || defined(UBRR1H))
   ,volatile uint8_t *ubrrh, volatile uint8_t *ubrrl,
   volatile uint8_t *ucsra, volatile uint8_t *ucsrb,
@@ -232,7 +236,9 @@ HardwareSerial::HardwareSerial(ring_buffer *rx_buffer, ring_buffer *tx_buffer
   uint8_t rxen, uint8_t txen, uint8_t rxcie, uint8_t udrie, uint8_t u2x)
 {
   _rx_buffer = rx_buffer;
+  #if SERIAL_TX_BUFFER_SIZE
   _tx_buffer = tx_buffer;
+  #endif
   _ubrrh = ubrrh;
   _ubrrl = ubrrl;
   _ucsra = ucsra;
@@ -243,12 +249,16 @@ HardwareSerial::HardwareSerial(ring_buffer *rx_buffer, ring_buffer *tx_buffer
   _rxcie = rxcie;
   _udrie = udrie;
   _u2x = u2x;
+  #if SERIAL_TX_BUFFER_SIZE
+  _frame_left = 0;
+  #endif
 }
 #else
 )
 {
   _rx_buffer = rx_buffer;
-  _tx_buffer = tx_buffer;
+  _tx_buffer = tx_buffer;  // The LIN UART always has one
+  _frame_left = 0;
 }
 #endif
 
@@ -306,8 +316,7 @@ try_again:
 
 void HardwareSerial::end()
 {
-  while (_tx_buffer->head != _tx_buffer->tail)
-    ;
+  flush();
 #if ( defined(UBRRH) || defined(UBRR0H) || defined(UBRR1H))
   cbi(*_ucsrb, _rxen);
   cbi(*_ucsrb, _txen);
@@ -322,69 +331,143 @@ void HardwareSerial::end()
   cbi(LINCR,LCMD2);
 #endif
 
-  _rx_buffer->head = _rx_buffer->tail;
+  _rx_buffer->clear();
 }
 
 int HardwareSerial::available(void)
 {
-  return (unsigned int)(SERIAL_BUFFER_SIZE + _rx_buffer->head - _rx_buffer->tail) % SERIAL_BUFFER_SIZE;
+  return _rx_buffer->available();
 }
 
 int HardwareSerial::peek(void)
 {
-  if (_rx_buffer->head == _rx_buffer->tail) {
-    return -1;
-  } else {
-    return _rx_buffer->buffer[_rx_buffer->tail];
-  }
+  return _rx_buffer->peek();
 }
 
 int HardwareSerial::read(void)
 {
-  // if the head isn't ahead of the tail, we don't have any characters
-  if (_rx_buffer->head == _rx_buffer->tail) {
-    return -1;
-  } else {
-    unsigned char c = _rx_buffer->buffer[_rx_buffer->tail];
-    _rx_buffer->tail = (_rx_buffer->tail + 1) % SERIAL_BUFFER_SIZE;
-    return c;
-  }
+  return _rx_buffer->get();
 }
 
 void HardwareSerial::flush()
 {
-  while (_tx_buffer->head != _tx_buffer->tail)
+  #if SERIAL_TX_BUFFER_SIZE
+  while (frameBusy() || !_tx_buffer->empty())
     ;
+  #endif
 }
 
 size_t HardwareSerial::write(uint8_t c)
 {
-  byte i = (_tx_buffer->head + 1) % SERIAL_BUFFER_SIZE;
-
+  #if !SERIAL_TX_BUFFER_SIZE
+  // Unbuffered, UDRE in UCSRA is the same bit as UDRIE in UCSRB (and it's
+  // UDRE we are passed as udrie anyway)
+  while (!(*_ucsra & _BV(_udrie)))
+    ;
+  *_udr = c;
+  #else
   // If the output buffer is full, there's nothing for it other than to
   // wait for the interrupt handler to empty it a bit
   // ???: return 0 here instead?
-  while (i == _tx_buffer->tail)
+  while (!_tx_buffer->put(c))
     ;
 
-  _tx_buffer->buffer[_tx_buffer->head] = c;
-  _tx_buffer->head = i;
+  _startTx();
+  #endif // SERIAL_TX_BUFFER_SIZE
+
 
+  return 1;
+}
+
+size_t HardwareSerial::write(const uint8_t *buffer, size_t size)
+{
+  #if !SERIAL_TX_BUFFER_SIZE
+  return Print::write(buffer, size);
+  #else
+  // Copy as much as fits each time round, so the interrupt is only kicked
+  // once for every chunk rather than for every byte.
+  size_t left = size;
+  while (left) {
+    uint8_t n = _tx_buffer->put(buffer, left > 255 ? 255 : (uint8_t)left);
+    if (n) {
+      buffer += n;
+      left -= n;
+      _startTx();
+    }
+  }
+  return size;
+  #endif
+}
+
+int HardwareSerial::availableForWrite(void)
+{
+  #if !SERIAL_TX_BUFFER_SIZE
+  return (*_ucsra & _BV(_udrie)) ? 1 : 0;
+  #else
+  return _tx_buffer->room();
+  #endif
+}
+
+void HardwareSerial::writeFrame(const uint8_t *frame, uint16_t length, void (*done)(void))
+{
+  #if !SERIAL_TX_BUFFER_SIZE
+  while (length--)
+    write(*frame++);
+  if (done) done();
+  #else
+  // Frames never get mixed up with what write() put in the buffer, nor with
+  // each other
+  flush();
+  if (!length) {
+    if (done) done();
+    return;
+  }
+  uint8_t oldSREG = SREG;
+  cli();
+  _frame_data = frame;
+  _frame_done = done;
+  _frame_left = length;
+  SREG = oldSREG;
+  _startTx();
+  #endif
+}
+
+bool HardwareSerial::frameBusy(void)
+{
+  #if !SERIAL_TX_BUFFER_SIZE
+  return false;
+  #else
+  // Two bytes, which the interrupt counts down
+  uint8_t oldSREG = SREG;
+  cli();
+  bool busy = _frame_left != 0;
+  SREG = oldSREG;
+  return busy;
+  #endif
+}
+
+#if SERIAL_TX_BUFFER_SIZE
+// There is something in the buffer, make sure the interrupt is sending it
+void HardwareSerial::_startTx(void)
+{
   #if ( defined(UBRRH) || defined(UBRR0H) || defined(UBRR1H) )
   sbi(*_ucsrb, _udrie);
   #else
+  uint8_t oldSREG = SREG;
+  cli();
   if(!(LINENIR & _BV(LENTXOK))){
-    //The buffer was previously empty, so enable TX Complete interrupt and load first byte.
-    sbi(LINENIR,LENTXOK);
-    unsigned char c = tx_buffer.buffer[tx_buffer.tail];
-    tx_buffer.tail = (tx_buffer.tail + 1) % SERIAL_BUFFER_SIZE;
-    LINDAT = c;
+    //The buffer was previously empty, so load the first byte and enable TX Complete interrupt.
+    int c = next_tx_byte(Serial, tx_buffer);
+    if (c >= 0) {
+      LINDAT = c;
+      sbi(LINENIR,LENTXOK);
+      if (c & 0x100) tx_frame_sent(Serial);
+    }
   }
+  SREG = oldSREG;
   #endif
-
-
-  return 1;
 }
+#endif
 
 HardwareSerial::operator bool() {
   return true;
@@ -392,17 +475,23 @@ HardwareSerial::operator bool() {
 
 // Preinstantiate Objects //////////////////////////////////////////////////////
 
+#if SERIAL_TX_BUFFER_SIZE
+  #define SERIAL_TX_BUFFER_ARG(b) , b
+#else
+  #define SERIAL_TX_BUFFER_ARG(b)
+#endif
+
 #if defined(UBRRH) && defined(UBRRL)
-  HardwareSerial Serial(&rx_buffer, &tx_buffer, &UBRRH, &UBRRL, &UCSRA, &UCSRB, &UDR, RXEN, TXEN, RXCIE, UDRE, U2X);
+  HardwareSerial Serial(&rx_buffer SERIAL_TX_BUFFER_ARG(&tx_buffer), &UBRRH, &UBRRL, &UCSRA, &UCSRB, &UDR, RXEN, TXEN, RXCIE, UDRE, U2X);
 #elif defined(UBRR0H) && defined(UBRR0L)
-  HardwareSerial Serial(&rx_buffer, &tx_buffer, &UBRR0H, &UBRR0L, &UCSR0A, &UCSR0B, &UDR0, RXEN0, TXEN0, RXCIE0, UDRE0, U2X0);
+  HardwareSerial Serial(&rx_buffer SERIAL_TX_BUFFER_ARG(&tx_buffer), &UBRR0H, &UBRR0L, &UCSR0A, &UCSR0B, &UDR0, RXEN0, TXEN0, RXCIE0, UDRE0, U2X0);
 #elif defined(LINBRRH)
   HardwareSerial Serial(&rx_buffer, &tx_buffer);
 #endif
 
 
 #if defined(UBRR1H)
-  HardwareSerial Serial1(&rx_buffer1, &tx_buffer1, &UBRR1H, &UBRR1L, &UCSR1A, &UCSR1B, &UDR1, RXEN1, TXEN1, RXCIE1, UDRE1, U2X1);
+  HardwareSerial Serial1(&rx_buffer1 SERIAL_TX_BUFFER_ARG(&tx_buffer1), &UBRR1H, &UBRR1L, &UCSR1A, &UCSR1B, &UDR1, RXEN1, TXEN1, RXCIE1, UDRE1, U2X1);
 #endif
 
 #endif // whole file
@@ -26,14 +26,48 @@
 #include <inttypes.h>
 
 #include "Stream.h"
+#include "RingBuffer.h"
 
-struct ring_buffer;
+// Sizes of the receive and transmit buffers, powers of two from 2 to 256.
+// A transmit buffer size of 0 means no buffer at all, write() waits for the
+// data register to be free and writes straight to it.  These are set by the
+// Tools -> Serial Buffers menu, or can be passed as -D options in the build
+// flags; the old SERIAL_BUFFER_SIZE still sets both if it is defined.
+#if !defined(SERIAL_RX_BUFFER_SIZE)
+  #if defined(SERIAL_BUFFER_SIZE)
+    #define SERIAL_RX_BUFFER_SIZE SERIAL_BUFFER_SIZE
+  #elif (RAMEND < 1000)
+    #define SERIAL_RX_BUFFER_SIZE 16
+  #else
+    #define SERIAL_RX_BUFFER_SIZE 64
+  #endif
+#endif
+#if !defined(SERIAL_TX_BUFFER_SIZE)
+  #if defined(SERIAL_BUFFER_SIZE)
+    #define SERIAL_TX_BUFFER_SIZE SERIAL_BUFFER_SIZE
+  #elif (RAMEND < 1000)
+    #define SERIAL_TX_BUFFER_SIZE 16
+  #else
+    #define SERIAL_TX_BUFFER_SIZE 64
+  #endif
+#endif
+
+#if (SERIAL_TX_BUFFER_SIZE == 0) && defined(LINBRRH)
+  #error "The LIN UART needs a transmit buffer, SERIAL_TX_BUFFER_SIZE can not be 0"
+#endif
+
+typedef RingBuffer<SERIAL_RX_BUFFER_SIZE> rx_ring_buffer;
+#if SERIAL_TX_BUFFER_SIZE
+typedef RingBuffer<SERIAL_TX_BUFFER_SIZE> tx_ring_buffer;
+#endif
 
 class HardwareSerial : public Stream
 {
   private:
-    volatile ring_buffer *_rx_buffer;
-    volatile ring_buffer *_tx_buffer;
+    rx_ring_buffer *_rx_buffer;
+    #if SERIAL_TX_BUFFER_SIZE
+    tx_ring_buffer *_tx_buffer;
+    #endif
     volatile uint8_t *_ubrrh;
     volatile uint8_t *_ubrrl;
     volatile uint8_t *_ucsra;
@@ -44,8 +78,12 @@ class HardwareSerial : public Stream
     uint8_t _rxcie;
     uint8_t _udrie;
     uint8_t _u2x;
+    void _startTx(void);
   public:
-    HardwareSerial(ring_buffer *rx_buffer, ring_buffer *tx_buffer
+    HardwareSerial(rx_ring_buffer *rx_buffer
+    #if SERIAL_TX_BUFFER_SIZE
+      , tx_ring_buffer *tx_buffer
+    #endif
     #if ( defined(UBRRH) || defined(UBRR0H) || defined(UBRR1H))
       ,
       volatile uint8_t *ubrrh, volatile uint8_t *ubrrl,
@@ -62,8 +100,28 @@ class HardwareSerial : public Stream
     virtual int read(void);
     virtual void flush(void);
     virtual size_t write(uint8_t);
-    using Print::write; // pull in write(str) and write(buf, size) from Print
+    virtual size_t write(const uint8_t *buffer, size_t size);
+    using Print::write; // pull in write(str) from Print
+    int availableForWrite(void);
     operator bool();
+
+    // Frame mode: send length bytes straight from frame, without copying them
+    // into the transmit buffer.  Anything already written goes out first, and
+    // if a frame is still being sent this waits for it.  The buffer belongs to
+    // the transmit interrupt until frameBusy() goes false or done is called
+    // (from the interrupt, once the last byte is handed to the UART), so with
+    // two buffers the sketch can fill one while the other is going out.
+    // With SERIAL_TX_BUFFER_SIZE 0 there is no interrupt to do it, so the
+    // frame has been sent by the time writeFrame() returns.
+    void writeFrame(const uint8_t *frame, uint16_t length, void (*done)(void) = NULL);
+    bool frameBusy(void);
+
+    #if SERIAL_TX_BUFFER_SIZE
+    // Only public so the transmit interrupt can get at them directly
+    const uint8_t * volatile _frame_data;
+    volatile uint16_t _frame_left;
+    void (* volatile _frame_done)(void);
+    #endif
 };
 
 #if (defined(UBRRH) || defined(UBRR0H) || defined(LINBRRH))
@@ -0,0 +1,117 @@
+/*
+  RingBuffer.h - single producer, single consumer byte FIFO for the serial ports
+  Part of ATTinyCore
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef RingBuffer_h
+#define RingBuffer_h
+
+#include <inttypes.h>
+
+// One side (usually an ISR) only ever calls put() and so only moves head,
+// the other only calls get()/peek()/clear() and so only moves tail.  Both are
+// single bytes, so reading either is atomic and neither side has to turn off
+// interrupts.
+//
+// SIZE must be a power of two, from 2 to 256, so that the indexes wrap with a
+// mask instead of a modulo.  One slot is sacrificed to tell full from empty,
+// so the buffer holds SIZE - 1 bytes.
+template <uint16_t SIZE>
+struct RingBuffer
+{
+  static_assert(SIZE >= 2 && SIZE <= 256 && (SIZE & (SIZE - 1)) == 0, "RingBuffer size must be a power of two from 2 to 256");
+  static const uint8_t MASK = (uint8_t)(SIZE - 1);
+
+  volatile uint8_t buffer[SIZE];
+  volatile uint8_t head;
+  volatile uint8_t tail;
+
+  // Producer side //////////////////////////////////////////////////////////
+
+  // Returns false (and drops c) if the buffer is full.
+  inline bool put(uint8_t c)
+  {
+    uint8_t h = head;
+    uint8_t i = (uint8_t)(h + 1) & MASK;
+    if (i == tail) return false;
+    buffer[h] = c;
+    head = i;
+    return true;
+  }
+
+  // Copies as much of data as there is room for and publishes it with a
+  // single update of head, returns how many bytes were copied.
+  inline uint8_t put(const uint8_t *data, uint8_t len)
+  {
+    uint8_t h = head;
+    uint8_t room = (uint8_t)(tail - h - 1) & MASK;
+    if (len > room) len = room;
+    for (uint8_t n = len; n; n--) {
+      buffer[h] = *data++;
+      h = (uint8_t)(h + 1) & MASK;
+    }
+    head = h;
+    return len;
+  }
+
+  inline bool full() const
+  {
+    return ((uint8_t)(head + 1) & MASK) == tail;
+  }
+
+  // How many bytes put() could take right now
+  inline uint8_t room() const
+  {
+    return (uint8_t)(tail - head - 1) & MASK;
+  }
+
+  // Consumer side //////////////////////////////////////////////////////////
+
+  // Returns -1 if the buffer is empty.
+  inline int get()
+  {
+    uint8_t t = tail;
+    if (t == head) return -1;
+    uint8_t c = buffer[t];
+    tail = (uint8_t)(t + 1) & MASK;
+    return c;
+  }
+
+  inline int peek() const
+  {
+    uint8_t t = tail;
+    if (t == head) return -1;
+    return buffer[t];
+  }
+
+  inline uint8_t available() const
+  {
+    return (uint8_t)(head - tail) & MASK;
+  }
+
+  inline bool empty() const
+  {
+    return head == tail;
+  }
+
+  inline void clear()
+  {
+    tail = head;
+  }
+};
+
+#endif
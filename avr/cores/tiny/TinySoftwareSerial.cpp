@@ -31,10 +31,65 @@
 #if (USE_SERIAL_TYPE == SERIAL_TYPE_SOFTWARE)
 #include "TinySoftwareSerial.h"
 
-// Define constants and variables for buffering incoming serial data.  We're
-// using a ring buffer (I think), in which rx_buffer_head is the index of the
-// location to which to write the next incoming character and rx_buffer_tail
-// is the index of the location from which to read.
+// Incoming characters are put() into rx_buffer by the comparator interrupt
+// (or the Timer1 compare B interrupt, see below) and read by the sketch, see
+// RingBuffer.h.  If it is full they are dropped.
+soft_ring_buffer rx_buffer;
+
+#if SERIAL_TX_BUFFER_SIZE
+soft_tx_ring_buffer tx_buffer;
+
+// Interrupt driven, full duplex mode.  Timer1 free runs and its two compare
+// registers step along one bit at a time: compare A shifts out the bits of
+// the byte being sent, compare B samples the bits of the byte being received.
+// The comparator interrupt only catches the start bit.
+
+#if (TIMER_TO_USE_FOR_MILLIS == 1)
+  #error "The interrupt driven software serial needs Timer1, which is being used for millis()"
+#endif
+
+#if !defined(TIMER1_COMPA_vect) && defined(TIM1_COMPA_vect)
+  #define TIMER1_COMPA_vect TIM1_COMPA_vect
+#endif
+#if !defined(TIMER1_COMPB_vect) && defined(TIM1_COMPB_vect)
+  #define TIMER1_COMPB_vect TIM1_COMPB_vect
+#endif
+
+#if defined(TIMSK1)
+  #define SOFT_SERIAL_TIMSK TIMSK1
+  #define SOFT_SERIAL_TIFR  TIFR1
+#else
+  #define SOFT_SERIAL_TIMSK TIMSK
+  #define SOFT_SERIAL_TIFR  TIFR
+#endif
+
+#if defined(PLLTIMER1)
+  #define SOFT_SERIAL_TIMER_CLOCK 64000000UL
+#elif defined(LOWPLLTIMER1)
+  #define SOFT_SERIAL_TIMER_CLOCK 32000000UL
+#else
+  #define SOFT_SERIAL_TIMER_CLOCK F_CPU
+#endif
+
+#if defined(OCR1AH)
+  #define SOFT_SERIAL_TICKS_MAX 0xFFFF
+#else
+  #define SOFT_SERIAL_TICKS_MAX 0xFF
+#endif
+
+// Roughly the cycles from the start bit edge to the comparator interrupt
+// reading TCNT1, plus those from the compare B match to reading the pin.
+#define SOFT_SERIAL_LATENCY 40
+
+// Bits of the byte being sent, LSB first: start bit, 8 data bits, stop bit,
+// and a marker above them.  Nothing is being sent when only the marker is
+// left (or at all, before the first byte).
+static uint16_t tx_shift;
+
+// Bits of the byte being received, shifted in from the top, below a marker
+// bit which falls out the bottom with the eighth data bit.
+static uint8_t rx_shift;
+#endif
 
 extern "C"{
 uint8_t getch() {
@@ -87,42 +142,148 @@ void uartDelay() {
 #elif !defined (ANALOG_COMP_vect)
   #error Tiny Software Serial cannot find the Analog comparator interrupt vector!
 #endif
+#if !SERIAL_TX_BUFFER_SIZE
 ISR(ANALOG_COMP_vect){
   char ch = getch(); //read in the character softwarily - I know its not a word, but it sounded cool, so you know what: #define softwarily 1
-  store_char(ch, Serial._rx_buffer);
+  Serial._rx_buffer->put(ch);
   sbi(ACSR,ACI); //clear the flag.
 }
+#else
+ISR(ANALOG_COMP_vect){
+  // Start bit: have compare B sample the middle of each data bit, and stop
+  // listening to the comparator until the byte is in.
+  OCR1B = TCNT1 + Serial._startTicks;
+  SOFT_SERIAL_TIFR = _BV(OCF1B); // only that flag, not a pending compare A
+  sbi(SOFT_SERIAL_TIMSK, OCIE1B);
+  cbi(ACSR,ACIE);
+  rx_shift = 0x80;
+}
+
+ISR(TIMER1_COMPB_vect){
+  uint8_t level = ANALOG_COMP_PIN & Serial._rxmask;
+  OCR1B += Serial._bitTicks;
+  uint8_t shift = rx_shift;
+  uint8_t done = shift & 1;
+  shift >>= 1;
+  if (level) shift |= 0x80;
+  if (!done) {
+    rx_shift = shift;
+    return;
+  }
+  rx_buffer.put(shift);
+  // Back to waiting for a start bit.  The stop bit is still to come, but the
+  // edge into it is the one the comparator does not interrupt on.
+  cbi(SOFT_SERIAL_TIMSK, OCIE1B);
+  sbi(ACSR,ACI); //clear the flag.
+  sbi(ACSR,ACIE);
+}
+
+ISR(TIMER1_COMPA_vect){
+  uint16_t shift = tx_shift;
+  if (shift <= 1) {
+    int c = tx_buffer.get();
+    if (c < 0) {
+      // The stop bit has been out for a whole bit, and that's all
+      cbi(SOFT_SERIAL_TIMSK, OCIE1A);
+      return;
+    }
+    shift = ((uint16_t)c << 1) | 0x600;
+  }
+  if (shift & 1) {
+    ANALOG_COMP_PORT |= Serial._txmask;
+  } else {
+    ANALOG_COMP_PORT &= Serial._txunmask;
+  }
+  tx_shift = shift >> 1;
+  OCR1A += Serial._bitTicks;
+}
+#endif
 
 }
-soft_ring_buffer rx_buffer  =  { { 0 }, 0, 0 };
 
 // Constructor ////////////////////////////////////////////////////////////////
 
-TinySoftwareSerial::TinySoftwareSerial(soft_ring_buffer *rx_buffer, uint8_t txBit, uint8_t rxBit)
+TinySoftwareSerial::TinySoftwareSerial(soft_ring_buffer *rx_buffer,
+#if SERIAL_TX_BUFFER_SIZE
+  soft_tx_ring_buffer *tx_buffer,
+#endif
+  uint8_t txBit, uint8_t rxBit)
 {
   _rx_buffer = rx_buffer;
+  #if SERIAL_TX_BUFFER_SIZE
+  _tx_buffer = tx_buffer;
+  #endif
 
   _rxmask = _BV(rxBit);
   _txmask = _BV(txBit);
   _txunmask = ~_txmask;
 
   _delayCount = 0;
+  _bitCycles = 0;
+  _baudError = 0;
 }
 
 // Public Methods //////////////////////////////////////////////////////////////
 void TinySoftwareSerial::setTxBit(uint8_t txbit)
 {
   _txmask=_BV(txbit);
-  _txunmask=~txbit;
+  _txunmask=~_txmask;
 }
 
-void TinySoftwareSerial::begin(long baud)
+// Work out the bit timing for baud, false if it is out of reach
+bool TinySoftwareSerial::_setBaud(long baud)
 {
+#if SERIAL_TX_BUFFER_SIZE
+  // Use the smallest prescaler (1, 8 or 64) for which the longest wait, the
+  // bit and a half from the start bit to the middle of the first data bit,
+  // still fits in the timer.
+  uint8_t shift = 0;
+  uint32_t ticks;
+  for (;;) {
+    ticks = ((SOFT_SERIAL_TIMER_CLOCK >> shift) + (baud >> 1)) / baud;
+    if (ticks + (ticks >> 1) <= SOFT_SERIAL_TICKS_MAX || shift == 6) break;
+    shift += 3;
+  }
+  uint16_t latency = ((uint32_t)SOFT_SERIAL_LATENCY * (SOFT_SERIAL_TIMER_CLOCK / F_CPU)) >> shift;
+  if ((ticks + (ticks >> 1) > SOFT_SERIAL_TICKS_MAX) || (ticks <= latency)) {
+    return false; //Can't get anywhere near that baud rate
+  }
+  _bitTicks = ticks;
+  _startTicks = ticks + (ticks >> 1) - latency;
+
+  // Free running, no PWM, no tone()
+  SOFT_SERIAL_TIMSK &= ~(_BV(OCIE1A) | _BV(OCIE1B));
+  #if defined(TCCR1) //ATtiny x5, prescaler is 2^(CS-1)
+  GTCCR &= ~(_BV(PWM1B) | _BV(COM1B1) | _BV(COM1B0));
+  TCCR1 = (shift + 1) << CS10;
+  #elif defined(TCCR1E) //ATtiny x61, likewise, and it always counts to OCR1C
+  TCCR1A = 0;
+  TCCR1C = 0;
+  TCCR1D = 0;
+  TC1H = 0;
+  OCR1C = 0xFF;
+  TCCR1B = (shift + 1) << CS10;
+  #else // 1, 8, 64
+  TCCR1A = 0;
+  TCCR1B = (shift / 3 + 1) << CS10;
+  #endif
+#else
   long tempDelay = (((F_CPU/baud)-39)/12);
   if ((tempDelay > 255) || (tempDelay <= 0)){
-  end(); //Cannot start as it would screw up uartDelay().
+    return false; //Cannot start as it would screw up uartDelay().
   }
   _delayCount = (uint8_t)tempDelay;
+#endif
+  return true;
+}
+
+void TinySoftwareSerial::begin(long baud)
+{
+  if (!_setBaud(baud)) {
+    end();
+    return;
+  }
+  _bitCycles = F_CPU / baud;
   cbi(ACSR,ACIE);  //turn off the comparator interrupt to allow change of ACD
 #ifdef ACBG
   sbi(ACSR,ACBG); //enable the internal bandgap reference - used instead of AIN0 to allow it to be used for TX.
@@ -147,6 +308,10 @@ void TinySoftwareSerial::begin(long baud)
 
 void TinySoftwareSerial::end()
 {
+#if SERIAL_TX_BUFFER_SIZE
+  flush();
+  SOFT_SERIAL_TIMSK &= ~(_BV(OCIE1A) | _BV(OCIE1B));
+#endif
   sbi(ACSR,ACI); //clear the flag.
   cbi(ACSR,ACIE);  //turn off the comparator interrupt to allow change of ACD, and because it needs to be turned off now too!
 #ifdef ACBG
@@ -154,51 +319,43 @@ void TinySoftwareSerial::end()
 #endif
   sbi(ACSR,ACD);  //turn off the comparator to save power
   _delayCount = 0;
-  _rx_buffer->head = _rx_buffer->tail;
+  _bitCycles = 0;
+  _rx_buffer->clear();
 }
 
 int TinySoftwareSerial::available(void)
 {
-  return (unsigned int)(SERIAL_BUFFER_SIZE + _rx_buffer->head - _rx_buffer->tail) % SERIAL_BUFFER_SIZE;
-}
-
-void store_char(unsigned char c, soft_ring_buffer *buffer)
-{
-  int i = (unsigned int)(buffer->head + 1) % SERIAL_BUFFER_SIZE;
-
-  // if we should be storing the received character into the location
-  // just before the tail (meaning that the head would advance to the
-  // current location of the tail), we're about to overflow the buffer
-  // and so we don't write the character or advance the head.
-  if (i != buffer->tail) {
-    buffer->buffer[buffer->head] = c;
-    buffer->head = i;
-  }
+  return _rx_buffer->available();
 }
 
 int TinySoftwareSerial::peek(void)
 {
-  if (_rx_buffer->head == _rx_buffer->tail) {
-    return -1;
-  } else {
-    return _rx_buffer->buffer[_rx_buffer->tail];
-  }
+  return _rx_buffer->peek();
 }
 
 int TinySoftwareSerial::read(void)
 {
-  // if the head isn't ahead of the tail, we don't have any characters
-  if (_rx_buffer->head == _rx_buffer->tail) {
-    return -1;
-  } else {
-    unsigned char c = _rx_buffer->buffer[_rx_buffer->tail];
-    _rx_buffer->tail = (unsigned int)(_rx_buffer->tail + 1) % SERIAL_BUFFER_SIZE;
-    return c;
-  }
+  return _rx_buffer->get();
 }
 
 size_t TinySoftwareSerial::write(uint8_t ch)
 {
+#if SERIAL_TX_BUFFER_SIZE
+  // If the buffer is full, wait for the interrupt to make room
+  while (!_tx_buffer->put(ch))
+    ;
+  if (!(SOFT_SERIAL_TIMSK & _BV(OCIE1A))) {
+    // Nothing being sent, start the bit clock a bit from now (the line has
+    // been idle for at least that long, so this is not cutting a stop bit short)
+    uint8_t oldSREG = SREG;
+    cli();
+    OCR1A = TCNT1 + _bitTicks;
+    SOFT_SERIAL_TIFR = _BV(OCF1A);
+    sbi(SOFT_SERIAL_TIMSK, OCIE1A);
+    SREG = oldSREG;
+  }
+  return 1;
+#else
   uint8_t oldSREG = SREG;
   cli(); //Prevent interrupts from breaking the transmission. Note: TinySoftwareSerial is half duplex.
   //it can either receive or send, not both (because receiving requires an interrupt and would stall transmission
@@ -234,11 +391,151 @@ size_t TinySoftwareSerial::write(uint8_t ch)
   );
   SREG = oldSREG;
   return 1;
+#endif
+}
+
+int TinySoftwareSerial::availableForWrite(void)
+{
+#if SERIAL_TX_BUFFER_SIZE
+  return _tx_buffer->room();
+#else
+  return 1; // write() never has to wait for anything but itself
+#endif
 }
 
 void TinySoftwareSerial::flush()
 {
+#if SERIAL_TX_BUFFER_SIZE
+  // The interrupt turns itself off once the last stop bit is done
+  while (SOFT_SERIAL_TIMSK & _BV(OCIE1A))
+    ;
+#endif
+}
 
+// Cycles per count of the edge timing loop in sync(), and the cycles spent
+// between samples at the edges it does not count, see the asm.
+#define SYNC_LOOP_CYCLES 6
+#define SYNC_EDGE_CYCLES 31
+
+bool TinySoftwareSerial::sync(uint8_t options, unsigned long timeout)
+{
+  if (!_bitCycles) return false; // begin() first
+  // The edges are timed with 16-bit counts, so a 'U' (with a bit of room for
+  // the other end being slow) has to fit in 65535 trips round the loop.
+  if (_bitCycles > (0xFFFFUL * SYNC_LOOP_CYCLES) / 9) return false;
+  flush();
+
+  uint8_t acie = ACSR & _BV(ACIE);
+  cbi(ACSR,ACIE); // we are looking at the start bit ourselves
+  #ifndef NO_MILLIS
+  unsigned long started = millis();
+  #else
+  (void)timeout;
+  #endif
+
+  // Times from the end of the start bit of a 'U' (0x55, so every bit is the
+  // opposite of the last) to each of the next 8 edges, the last of which is
+  // the start of the stop bit.
+  uint16_t counts[8];
+  for (;;) {
+    sbi(ACSR,ACI); //clear the flag.
+    // Wait for a start bit with interrupts still on, so millis() keeps going;
+    // the comparator flag tells us one came even if an interrupt made us late.
+    while (!(ACSR & _BV(ACI))) {
+      #ifndef NO_MILLIS
+      if (millis() - started >= timeout) {
+        ACSR |= acie;
+        return false;
+      }
+      #endif
+    }
+
+    uint8_t left;
+    uint16_t cnt;
+    uint16_t *store = counts;
+    uint8_t oldSREG = SREG;
+    cli();
+    __asm__ __volatile__ (
+      "   ldi  %[left], 4        \n"
+      "   clr  %A[cnt]           \n"
+      "   clr  %B[cnt]           \n"
+      "0: adiw %[cnt], 1         \n" // wait for the end of the start bit
+      "   breq 9f                \n"
+      "   sbis %[pin], %[bit]    \n"
+      "   rjmp 0b                \n"
+      "   clr  %A[cnt]           \n"
+      "   clr  %B[cnt]           \n"
+      "1: adiw %[cnt], 1         \n" // wait for a falling edge
+      "   breq 9f                \n"
+      "   sbic %[pin], %[bit]    \n"
+      "   rjmp 1b                \n"
+      "   st   X+, %A[cnt]       \n"
+      "   st   X+, %B[cnt]       \n"
+      "2: adiw %[cnt], 1         \n" // wait for a rising edge
+      "   breq 9f                \n"
+      "   sbis %[pin], %[bit]    \n"
+      "   rjmp 2b                \n"
+      "   st   X+, %A[cnt]       \n"
+      "   st   X+, %B[cnt]       \n"
+      "   dec  %[left]           \n"
+      "   brne 1b                \n"
+      "9:                        \n" // the count wrapped: no edge, left != 0
+      : [left] "=&d" (left),
+        [cnt] "=&w" (cnt),
+        "+x" (store)
+      : [pin] "I" (_SFR_IO_ADDR(ANALOG_COMP_PIN)),
+        [bit] "I" (ANALOG_COMP_AIN1_BIT)
+      : "memory"
+    );
+    SREG = oldSREG;
+    if (left) continue;
+
+    // If it wasn't a 'U', or we only got to it after its first edge, the bits
+    // will not all be the same length.
+    uint16_t total = counts[7];
+    uint16_t bit = total >> 3;
+    uint16_t slack = total >> 5;
+    uint16_t prev = 0;
+    uint8_t i;
+    for (i = 0; i < 8; i++) {
+      uint16_t len = counts[i] - prev;
+      if (len + slack < bit || len > bit + slack) break;
+      prev = counts[i];
+    }
+    if (i == 8) break;
+  }
+  sbi(ACSR,ACI); //clear the flag, our edges set it.
+  ACSR |= acie;
+
+  uint32_t cycles = (uint32_t)SYNC_LOOP_CYCLES * counts[7] + SYNC_EDGE_CYCLES;
+  uint32_t expected = _bitCycles * 8;
+  _baudError = ((int32_t)(cycles - expected) * 1000) / (int32_t)expected;
+
+  #ifdef OSCCAL
+  // Each step of OSCCAL is somewhere around 0.5 to 1%.  Either half of the
+  // range is fine, but don't step from one into the other.
+  if ((options & SERIAL_SYNC_OSCCAL) && (_baudError > 4 || _baudError < -4)) {
+    uint8_t cal = OSCCAL;
+    if (_baudError > 0 && (cal & 0x7F) != 0) {
+      OSCCAL = cal - 1;
+      return true; // the clock has changed, so the timing has to wait for the next sync()
+    }
+    if (_baudError < 0 && (cal & 0x7F) != 0x7F) {
+      OSCCAL = cal + 1;
+      return true;
+    }
+  }
+  #endif
+  if (options & SERIAL_SYNC_BAUD) {
+    // The baud rate that, by our clock, gives bits as long as we just saw
+    _setBaud((8UL * F_CPU + (cycles >> 1)) / cycles);
+  }
+  return true;
+}
+
+int16_t TinySoftwareSerial::baudError(void)
+{
+  return _baudError;
 }
 
 TinySoftwareSerial::operator bool() {
@@ -266,6 +563,10 @@ TinySoftwareSerial::operator bool() {
 #error Please define ANALOG_COMP_AIN1_BIT in the pins_arduino.h file!
 #endif
 
+#if SERIAL_TX_BUFFER_SIZE
+TinySoftwareSerial Serial(&rx_buffer, &tx_buffer, ANALOG_COMP_AIN0_BIT, ANALOG_COMP_AIN1_BIT);
+#else
 TinySoftwareSerial Serial(&rx_buffer, ANALOG_COMP_AIN0_BIT, ANALOG_COMP_AIN1_BIT);
+#endif
 
 #endif // whole file
@@ -3,26 +3,51 @@
 #define TinySoftwareSerial_h
 #include <inttypes.h>
 #include "Stream.h"
+#include "RingBuffer.h"
 
 #if !defined(ACSR) && defined(ACSRA)
 #define ACSR ACSRA
 #endif
 
-#if (RAMEND < 250)
-  #define SERIAL_BUFFER_SIZE 8
-#elif (RAMEND < 500)
-  #define SERIAL_BUFFER_SIZE 16
-#elif (RAMEND < 1000)
-  #define SERIAL_BUFFER_SIZE 32
+// Size of the receive buffer, a power of two from 2 to 256.  Set by the
+// Tools -> Serial Buffers menu, or can be passed as a -D option in the build
+// flags; the old SERIAL_BUFFER_SIZE still works.
+#if !defined(SERIAL_RX_BUFFER_SIZE)
+  #if defined(SERIAL_BUFFER_SIZE)
+    #define SERIAL_RX_BUFFER_SIZE SERIAL_BUFFER_SIZE
+  #elif (RAMEND < 250)
+    #define SERIAL_RX_BUFFER_SIZE 8
+  #elif (RAMEND < 500)
+    #define SERIAL_RX_BUFFER_SIZE 16
+  #elif (RAMEND < 1000)
+    #define SERIAL_RX_BUFFER_SIZE 32
+  #else
+    #define SERIAL_RX_BUFFER_SIZE 128
+  #endif
+#endif
+
+// Size of the transmit buffer.  0 (the default) means write() bit-bangs each
+// byte with interrupts off, which stops anything being received meanwhile.
+// Anything else (a power of two from 2 to 256) takes over Timer1: write()
+// only queues the byte, one compare interrupt shifts the bits out while the
+// other samples the bits received, both on the same bit clock, so it is full
+// duplex.  Timer1 can then not be used for PWM or tone().
+#if !defined(SERIAL_TX_BUFFER_SIZE)
+  #define SERIAL_TX_BUFFER_SIZE 0
+#endif
+
+typedef RingBuffer<SERIAL_RX_BUFFER_SIZE> soft_ring_buffer;
+#if SERIAL_TX_BUFFER_SIZE
+typedef RingBuffer<SERIAL_TX_BUFFER_SIZE> soft_tx_ring_buffer;
+
+// The timer compare registers are 16 bit on parts with a 16 bit Timer1, 8
+// bit (counting 0 to 255) on the others.
+#if defined(OCR1AH)
+typedef uint16_t soft_serial_ticks;
 #else
-  #define SERIAL_BUFFER_SIZE 128
+typedef uint8_t soft_serial_ticks;
+#endif
 #endif
-struct soft_ring_buffer
-{
-  volatile unsigned char buffer[SERIAL_BUFFER_SIZE];
-  volatile int head;
-  volatile int tail;
-};
 
 // When LTO is enabled, the linker drops uartDelay out because
 // it doesn't look used, then it complains that it actually did
@@ -31,9 +56,12 @@ struct soft_ring_buffer
 extern "C"{
   void uartDelay() __attribute__ ((naked,used)); //used attribute needed to prevent LTO from throwing it out.
   uint8_t getch();
-  void store_char(unsigned char c, soft_ring_buffer *buffer);
 }
 
+// Options for Serial.sync()
+#define SERIAL_SYNC_BAUD   0x01 // retime the bits to match the other end
+#define SERIAL_SYNC_OSCCAL 0x02 // step OSCCAL towards the right speed instead, if it is off by more than about half a step
+
 class TinySoftwareSerial : public Stream
 {
   public: //should be private but needed by extern "C" {} functions.
@@ -42,8 +70,20 @@ class TinySoftwareSerial : public Stream
   uint8_t _txunmask;
   soft_ring_buffer *_rx_buffer;
   uint8_t _delayCount;
+  uint32_t _bitCycles;              // nominal CPU cycles per bit, for sync() (over 65535 at low baud and high F_CPU)
+  int16_t _baudError;
+  bool _setBaud(long);
+  #if SERIAL_TX_BUFFER_SIZE
+  soft_tx_ring_buffer *_tx_buffer;
+  soft_serial_ticks _bitTicks;      // Timer1 ticks per bit
+  soft_serial_ticks _startTicks;    // from the start bit edge to the middle of the first data bit
+  #endif
   public:
-    TinySoftwareSerial(soft_ring_buffer *rx_buffer, uint8_t txBit, uint8_t rxBit);
+    TinySoftwareSerial(soft_ring_buffer *rx_buffer,
+    #if SERIAL_TX_BUFFER_SIZE
+      soft_tx_ring_buffer *tx_buffer,
+    #endif
+      uint8_t txBit, uint8_t rxBit);
     void begin(long);
     void setTxBit(uint8_t);
     void end();
@@ -53,7 +93,18 @@ class TinySoftwareSerial : public Stream
     virtual void flush(void);
     virtual size_t write(uint8_t);
     using Print::write; // pull in write(str) and write(buf, size) from Print
+    int availableForWrite(void);
     operator bool();
+
+    // Waits (for up to timeout ms, or for ever with millis() disabled) for
+    // the other end to send a 'U' (0x55), times it, and depending on options
+    // adjusts our bit timing and/or OSCCAL to make up for the internal
+    // oscillator being off.  Any other characters that arrive meanwhile are
+    // lost, so have the other end send a few 'U's.  False on timeout.
+    bool sync(uint8_t options = SERIAL_SYNC_BAUD, unsigned long timeout = 1000);
+    // How far off our clock was at the last sync(), in parts per thousand,
+    // positive if it is running fast.
+    int16_t baudError(void);
 };
 
 extern TinySoftwareSerial Serial;
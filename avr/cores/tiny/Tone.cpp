@@ -52,6 +52,123 @@ static volatile uint8_t tone_timer_pin_mask;
 static uint8_t tone_pin = 255;
 static unsigned long freq=0;
 
+// Called from the ISR when a note with a duration ends, returns true if it
+// started another one.  Only set once toneQueue() is used, so that the queue
+// (and its RAM) is not linked into sketches which don't use it.
+static bool (*tone_next)(void);
+static void toneQueueClear(void);
+
+/* The clock the tone timer counts: on the x5 and x61 Timer1 can run from the PLL */
+#if (TIMER_TO_USE_FOR_TONE == 1) && defined(PLLTIMER1)
+  #define TONE_TIMER_CLOCK 64000000UL
+#elif (TIMER_TO_USE_FOR_TONE == 1) && defined(LOWPLLTIMER1)
+  #define TONE_TIMER_CLOCK 32000000UL
+#else
+  #define TONE_TIMER_CLOCK F_CPU
+#endif
+
+/*
+  The clock select bits and compare value for a tone, packed as
+  (prescalarbits << 16) | (ocr - 1).  toneSettingForCycles() takes the number
+  of timer clocks in half a period, and is constexpr so that the note table
+  below is worked out by the compiler; 0 is never a valid setting (the clock
+  select bits would be stopped) so it means silence.  TONE_CYCLES_MAX is the
+  longest half period the timer can do; anything longer is played at that.
+*/
+typedef uint32_t tone_setting;
+#define TONE_SETTING(bits, ocr)   (((uint32_t)(bits) << 16) | (uint16_t)((ocr) - 1))
+#define toneSettingBits(s)        ((uint8_t)((s) >> 16))
+#define toneSettingOCR(s)         ((uint16_t)(s))
+
+#if (TIMER_TO_USE_FOR_TONE == 1) && defined(TCCR1E)
+#define TONE_CYCLES_MAX (256UL << 10)
+static constexpr tone_setting toneSettingForCycles(uint32_t c)
+{
+  return (c <= 256)        ? TONE_SETTING(0b0001, c)        // ck/1
+       : ((c >> 3) <= 256) ? TONE_SETTING(0b0100, c >> 3)   // ck/8
+       : ((c >> 6) <= 256) ? TONE_SETTING(0b0111, c >> 6)   // ck/64
+       : ((c >> 8) <= 256) ? TONE_SETTING(0b1001, c >> 8)   // ck/256
+       : ((c >> 10) <= 256) ? TONE_SETTING(0b1011, c >> 10) // ck/1024
+       :                     TONE_SETTING(0b1011, 256);
+}
+#elif (TIMER_TO_USE_FOR_TONE == 1) && defined(TCCR1) // ATtiny85, every power of two from 1 to 16384
+#define TONE_CYCLES_MAX (256UL << 14)
+static constexpr tone_setting toneSettingForCycles(uint32_t c, uint8_t bits = 0b0001)
+{
+  return (c > 0xFF && bits < 15) ? toneSettingForCycles(c >> 1, bits + 1) : TONE_SETTING(bits, (c <= 256) ? c : 256);
+}
+#elif (TIMER_TO_USE_FOR_TONE == 1)
+#define TONE_CYCLES_MAX (65536UL * 64)
+static constexpr tone_setting toneSettingForCycles(uint32_t c)
+{
+  return (c <= 0xFFFF) ? TONE_SETTING(0b001, c)
+       : (c < TONE_CYCLES_MAX) ? TONE_SETTING(0b011, c / 64)
+       : TONE_SETTING(0b011, 65536UL);
+}
+#elif (TIMER_TO_USE_FOR_TONE == 0)
+#define TONE_CYCLES_MAX (256UL << 10)
+static constexpr tone_setting toneSettingForCycles(uint32_t c)
+{
+  return (c <= 256)        ? TONE_SETTING(0b001, c)        // ck/1
+       : ((c >> 3) <= 256) ? TONE_SETTING(0b010, c >> 3)   // ck/8
+       : ((c >> 6) <= 256) ? TONE_SETTING(0b011, c >> 6)   // ck/64
+       : ((c >> 8) <= 256) ? TONE_SETTING(0b100, c >> 8)   // ck/256
+       : ((c >> 10) <= 256) ? TONE_SETTING(0b101, c >> 10) // ck/1024
+       :                     TONE_SETTING(0b101, 256);
+}
+#endif
+
+static void toneStopClock(void)
+{
+#if (TIMER_TO_USE_FOR_TONE == 0)
+  TCCR0B &= ~((1<<CS02)|(1<<CS01)|(1<<CS00));
+  TCNT0 = 0;
+#elif (TIMER_TO_USE_FOR_TONE == 1) && defined(TCCR1)
+  TCCR1 &= ~((1<<CS13)|(1<<CS12)|(1<<CS11)|(1<<CS10));
+  TCNT1 = 0;
+#elif (TIMER_TO_USE_FOR_TONE == 1) && defined(TCCR1E)
+  TCCR1B &= ~((1<<CS13)|(1<<CS12)|(1<<CS11)|(1<<CS10));
+  TCNT1 = 0;
+#elif (TIMER_TO_USE_FOR_TONE == 1)
+  TCCR1B &= ~((1<<CS12)|(1 << CS11)|(1 << CS10));
+  TCNT1 = 0;
+#endif
+}
+
+// Stops the clock, loads the compare register(s) and starts it again, the
+// only thing which changes from one note to the next.
+static void toneSetClock(tone_setting setting)
+{
+  toneStopClock();
+  uint16_t ocr = toneSettingOCR(setting);
+  uint8_t prescalarbits = toneSettingBits(setting);
+#if (TIMER_TO_USE_FOR_TONE == 0)
+  OCR0A = ocr;
+  //Clock is always stopped before this point, which means all of CS[0..2] are already 0, so can just use a bitwise OR to set required bits
+  TCCR0B |= (prescalarbits << CS00);
+#elif (TIMER_TO_USE_FOR_TONE == 1) && (defined(TCCR1) || defined(TCCR1E))
+  // OCR1C is TOP, OCR1A matches once per count up to it
+  OCR1C = ocr;
+  OCR1A = ocr;
+  #if defined(TCCR1)
+  TCCR1 |= (prescalarbits << CS10);
+  #else
+  TCCR1B |= (prescalarbits << CS10);
+  #endif
+#elif (TIMER_TO_USE_FOR_TONE == 1)
+  #if defined(__AVR_ATtiny167__) || defined(__AVR_ATtiny87__)
+  if(digitalPinToTimer(tone_pin)&0x04){
+    // the timer pin table now has the information we need!
+    OCR1B = ocr;
+  }
+  // OCR1A is used for interrupts / duration
+  #endif
+  OCR1A = ocr;
+  TCCR1B |= (prescalarbits << CS10);
+#endif
+}
+
+static void toneStart(uint8_t _pin, tone_setting setting, long toggles);
 
 void tone( uint8_t _pin, unsigned long frequency, unsigned long duration )
 {
@@ -59,6 +176,25 @@ void tone( uint8_t _pin, unsigned long frequency, unsigned long duration )
     return;
   }
   freq=frequency;
+  toneQueueClear();
+
+  tone_setting setting = 0;
+  long toggles = -1;
+  if ( frequency > 0 )
+  {
+    setting = toneSettingForCycles(TONE_TIMER_CLOCK / frequency / 2);
+    /* Does the caller want a specific duration? If so, how many times the value toggles */
+    if ( duration > 0 )
+    {
+      toggles = (2 * frequency * duration) / 1000;
+    }
+  }
+  toneStart(_pin, setting, toggles);
+}
+
+// toggles < 0 plays until noTone() (or the next tone())
+static void toneStart(uint8_t _pin, tone_setting setting, long toggles)
+{
 
   if ( tone_pin == 255 )
   {
@@ -321,121 +457,14 @@ void tone( uint8_t _pin, unsigned long frequency, unsigned long duration )
   if ( tone_pin == _pin )
   {
     /* Stop the clock while we make changes, then set the counter to zero to reduce ticks and scratches. */
+    toneStopClock();
 
-    // Millis timer is always processor clock divided by MillisTimer_Prescale_Value (64)
-#if (TIMER_TO_USE_FOR_TONE == 0)
-    TCCR0B &= ~((1<<CS02)|(1<<CS01)|(1<<CS00));
-    TCNT0 = 0;
-#elif (TIMER_TO_USE_FOR_TONE == 1) && defined(TCCR1)
-    TCCR1 &= ~((1<<CS13)|(1<<CS12)|(1<<CS11)|(1<<CS10));
-    TCNT1 = 0;
-#elif (TIMER_TO_USE_FOR_TONE == 1) && defined(TCCR1E)
-    TCCR1B &= ~((1<<CS13)|(1<<CS12)|(1<<CS11)|(1<<CS10));
-    TCNT1 = 0;
-#elif (TIMER_TO_USE_FOR_TONE == 1)
-    TCCR1B &= ~((1<<CS12)|(1 << CS11)|(1 << CS10));
-    TCNT1 = 0;
-#endif
-
-    if ( frequency > 0 )
+    if ( setting )
     {
-      /* Determine which prescaler to use */
-      /* Set the Output Compare Register (rounding up) */
-
-#if TIMER_TO_USE_FOR_TONE == 1
-  #ifdef PLLTIMER1
-  uint32_t ocr = 64000000UL / frequency / 2;
-  #else
-    #ifdef LOWPLLTIMER1
-  uint32_t ocr = 32000000UL / frequency / 2;
-    #else
-  uint32_t ocr = F_CPU / frequency / 2;
-    #endif
-  #endif
-  #if defined(TCCR1E)
-      uint8_t prescalarbits = 0b0001;
-      if (ocr > 256)
-      {
-        ocr >>= 3; //divide by 8
-        prescalarbits = 0b0100;  // ck/8
-        if (ocr > 256)
-        {
-          ocr >>= 3; //divide by a further 8
-          prescalarbits = 0b0111; //ck/64
-          if (ocr > 256)
-          {
-            ocr >>= 2; //divide by a further 4
-            prescalarbits = 0b1001; //ck/256
-            if (ocr > 256)
-            {
-              // can't do any better than /1024
-              ocr >>= 2; //divide by a further 4
-              prescalarbits = 0b1011; //ck/1024
-            }
-          }
-        }
-      }
-  #else
-    #if defined(TCCR1) //Start FANCY ATtiny85 code
-       uint8_t prescalarbits = 0b0001;
-       while (ocr > 0xff && prescalarbits < 15) {
-          prescalarbits++;
-          ocr>>=1;
-
-       }
-       OCR1C=ocr-1;
-    #else
-        uint8_t prescalarbits = 0b001;
-       if (ocr > 0xffff)
-        {
-         ocr /= 64;
-          prescalarbits = 0b011;
-        }
-    #endif
-     ocr -= 1; //Note we are doing the subtraction of 1 here to save repeatedly calculating ocr from just the frequency in the if tree above
-    #if defined(__AVR_ATtiny167__) || defined(__AVR_ATtiny87__)
-        if(digitalPinToTimer(_pin)&0x04){
-          // the timer pin table now has the information we need!
-          OCR1B = ocr;
-      }
-      // OCR1A is used for interrupts / duration
-    #endif
-      OCR1A = ocr;
-  #endif //  defined(TCCR1E)
-#elif TIMER_TO_USE_FOR_TONE == 0
-      uint32_t ocr = F_CPU / frequency / 2;
-      uint8_t prescalarbits = 0b001;  // ck/1
-      if (ocr > 256)
-      {
-        ocr >>= 3; //divide by 8
-        prescalarbits = 0b010;  // ck/8
-        if (ocr > 256)
-        {
-          ocr >>= 3; //divide by a further 8
-          prescalarbits = 0b011; //ck/64
-          if (ocr > 256)
-          {
-            ocr >>= 2; //divide by a further 4
-            prescalarbits = 0b100; //ck/256
-            if (ocr > 256)
-            {
-              // can't do any better than /1024
-              ocr >>= 2; //divide by a further 4
-              prescalarbits = 0b101; //ck/1024
-            }
-          }
-        }
-      }
-    ocr -= 1; //Note we are doing the subtraction of 1 here to save repeatedly calculating ocr from just the frequency in the if tree above
-      OCR0A = ocr;
-
-#endif
-
       /* Does the caller want a specific duration? */
-      if ( duration > 0 )
+      if ( toggles >= 0 )
       {
-        /* Determine how many times the value toggles */
-        tone_timer_toggle_count = (2 * frequency * duration) / 1000;
+        tone_timer_toggle_count = toggles;
         /* Output Compare A Match Interrupt Enable */
 #if (TIMER_TO_USE_FOR_TONE == 1)
   #if defined (TIMSK)
@@ -486,14 +515,8 @@ void tone( uint8_t _pin, unsigned long frequency, unsigned long duration )
 #endif
       }
 
-    //Clock is always stopped before this point, which means all of CS[0..2] are already 0, so can just use a bitwise OR to set required bits
-#if (TIMER_TO_USE_FOR_TONE == 0)
-      TCCR0B |= (prescalarbits << CS00);
-#elif (TIMER_TO_USE_FOR_TONE == 1) && defined(TCCR1)
-      TCCR1 |= (prescalarbits << CS10);
-#elif (TIMER_TO_USE_FOR_TONE == 1)
-      TCCR1B |= (prescalarbits << CS10);
-#endif
+      /* Load the compare register(s) and start the clock */
+      toneSetClock(setting);
 
     }
     else
@@ -540,6 +563,8 @@ void noTone( uint8_t _pin )
   if ( (tone_pin != 255)
         && ((tone_pin == _pin) || (_pin == 255)) )
   {
+    toneQueueClear();
+
     // Turn off all interrupts
     #if (TIMER_TO_USE_FOR_TONE == 1)
       #if defined (TIMSK)
@@ -576,6 +601,223 @@ void noTone( uint8_t _pin )
 }
 
 
+/*
+  Notes by number, as in MIDI: 60 is middle C, 69 the A at 440 Hz.  The
+  compare value and prescaler for each are worked out at compile time from
+  the top octave, so playing a note does no division.  The table only covers
+  C2 (36) to B7 (107), anything else is a rest.  Timer1 of the x61 running
+  from the 64 MHz PLL can't go below about 122 Hz even at /1024, so there the
+  table starts at C3 (48).
+*/
+#if (TIMER_TO_USE_FOR_TONE == 1) && defined(TCCR1E) && (TONE_TIMER_CLOCK > 32000000UL)
+  #define TONE_NOTE_FIRST 48
+#else
+  #define TONE_NOTE_FIRST 36
+#endif
+#define TONE_NOTE_LAST  107
+
+// C7 to B7 in tenths of a Hz
+static constexpr uint16_t toneTopOctave(uint8_t n)
+{
+  return n ==  0 ? 20930 : n ==  1 ? 22175 : n ==  2 ? 23493 : n ==  3 ? 24890 :
+         n ==  4 ? 26370 : n ==  5 ? 27938 : n ==  6 ? 29600 : n ==  7 ? 31360 :
+         n ==  8 ? 33224 : n ==  9 ? 35200 : n == 10 ? 37293 :           39511;
+}
+
+// Half a period is TONE_TIMER_CLOCK / (2 * f), each octave down doubles it
+static constexpr uint32_t toneCyclesForNote(uint8_t note)
+{
+  return (uint32_t)(((((unsigned long long)TONE_TIMER_CLOCK * 5) << (8 - note / 12)) + toneTopOctave(note % 12) / 2) / toneTopOctave(note % 12));
+}
+
+static constexpr tone_setting toneSettingForNote(uint8_t note)
+{
+  return toneSettingForCycles(toneCyclesForNote(note));
+}
+
+static_assert(toneCyclesForNote(TONE_NOTE_FIRST) <= TONE_CYCLES_MAX, "The lowest note in the table is too low for the tone timer");
+
+#define TONE_NOTE_OCTAVE(n) \
+  toneSettingForNote(n),     toneSettingForNote(n + 1), toneSettingForNote(n + 2),  toneSettingForNote(n + 3), \
+  toneSettingForNote(n + 4), toneSettingForNote(n + 5), toneSettingForNote(n + 6),  toneSettingForNote(n + 7), \
+  toneSettingForNote(n + 8), toneSettingForNote(n + 9), toneSettingForNote(n + 10), toneSettingForNote(n + 11)
+
+static const tone_setting tone_note_table[] PROGMEM = {
+  #if TONE_NOTE_FIRST == 36
+  TONE_NOTE_OCTAVE(36),
+  #endif
+  TONE_NOTE_OCTAVE(48), TONE_NOTE_OCTAVE(60),
+  TONE_NOTE_OCTAVE(72), TONE_NOTE_OCTAVE(84), TONE_NOTE_OCTAVE(96)
+};
+
+static const uint16_t tone_top_octave[12] PROGMEM = {
+  toneTopOctave(0), toneTopOctave(1), toneTopOctave(2),  toneTopOctave(3),
+  toneTopOctave(4), toneTopOctave(5), toneTopOctave(6),  toneTopOctave(7),
+  toneTopOctave(8), toneTopOctave(9), toneTopOctave(10), toneTopOctave(11)
+};
+
+// How many times the pin toggles while a note plays for duration ms
+static long toneNoteToggles(uint8_t note, unsigned long duration)
+{
+  uint16_t dHz = pgm_read_word(&tone_top_octave[note % 12]) >> (8 - note / 12);
+  return ((uint32_t)dHz * duration) / 5000;
+}
+
+void toneNote(uint8_t _pin, uint8_t note, unsigned long duration)
+{
+  freq = 0;
+  toneQueueClear();
+  if (note < TONE_NOTE_FIRST || note > TONE_NOTE_LAST)
+  {
+    toneStart(_pin, 0, -1);
+    return;
+  }
+  tone_setting setting = pgm_read_dword(&tone_note_table[note - TONE_NOTE_FIRST]);
+  toneStart(_pin, setting, duration ? toneNoteToggles(note, duration) : -1);
+}
+
+/*
+  The queue of notes for toneQueue(), played one after the other from the
+  compare interrupt.  Each entry holds everything the ISR needs to start the
+  next note, so all it does between notes is load the compare register(s).
+*/
+#ifndef TONE_QUEUE_SIZE
+  #if (RAMEND < 512)
+    #define TONE_QUEUE_SIZE 4
+  #else
+    #define TONE_QUEUE_SIZE 8
+  #endif
+#endif
+
+#if (TONE_QUEUE_SIZE & (TONE_QUEUE_SIZE - 1)) || TONE_QUEUE_SIZE > 128
+  #error "TONE_QUEUE_SIZE must be a power of two, no bigger than 128"
+#endif
+
+#define TONE_QUEUE_MASK (TONE_QUEUE_SIZE - 1)
+
+// Rests time themselves as a 500 Hz tone with the pin turned off
+#define TONE_REST          0x80000000UL
+#define TONE_REST_SETTING  (TONE_REST | toneSettingForCycles(TONE_TIMER_CLOCK / 1000))
+
+struct tone_queue_entry
+{
+  tone_setting setting;
+  long toggles;
+};
+
+static tone_queue_entry tone_queue[TONE_QUEUE_SIZE];
+static volatile uint8_t tone_queue_head;
+static volatile uint8_t tone_queue_tail;
+
+// A rest takes the pin off the output: clearing its DDR bit silences the
+// OCxA/OCxB pins, and a zero mask stops the ISR toggling any other pin.
+static void toneSilence(bool silent)
+{
+  volatile uint8_t *ddr = portModeRegister(digitalPinToPort(tone_pin));
+  uint8_t bit = digitalPinToBitMask(tone_pin);
+  if (silent)
+  {
+    *ddr &= ~bit;
+    if (tone_timer_pin_register != NULL)
+    {
+      *tone_timer_pin_register &= ~bit;
+      tone_timer_pin_mask = 0;
+    }
+  }
+  else
+  {
+    if (tone_timer_pin_register != NULL)
+    {
+      tone_timer_pin_mask = bit;
+    }
+    *ddr |= bit;
+  }
+}
+
+// Drop the rest of a tune, for when a note replaces it or noTone() stops it
+static void toneQueueClear(void)
+{
+  uint8_t oldSREG = SREG;
+  cli();
+  tone_next = NULL;
+  tone_queue_head = tone_queue_tail;
+  SREG = oldSREG;
+}
+
+static bool toneQueueNext(void)
+{
+  uint8_t tail = tone_queue_tail;
+  if (tail == tone_queue_head) return false;
+  tone_setting setting = tone_queue[tail].setting;
+  tone_timer_toggle_count = tone_queue[tail].toggles;
+  tone_queue_tail = (tail + 1) & TONE_QUEUE_MASK;
+  toneSilence(setting & TONE_REST);
+  toneSetClock(setting & ~TONE_REST);
+  return true;
+}
+
+static bool toneQueueSetting(uint8_t _pin, tone_setting setting, long toggles)
+{
+  // Anything shorter than one toggle would read as stopped to the ISR
+  if (toggles < 1) toggles = 1;
+
+  uint8_t oldSREG = SREG;
+  cli();
+  tone_next = toneQueueNext;
+  // Queue it behind the note that's playing, unless nothing is or it's one
+  // which would never end
+  if (tone_pin != 255 && tone_timer_toggle_count > 0)
+  {
+    bool queued = false;
+    if (tone_pin == _pin)
+    {
+      uint8_t head = tone_queue_head;
+      uint8_t next = (head + 1) & TONE_QUEUE_MASK;
+      if (next != tone_queue_tail)
+      {
+        tone_queue[head].setting = setting;
+        tone_queue[head].toggles = toggles;
+        tone_queue_head = next;
+        queued = true;
+      }
+    }
+    SREG = oldSREG;
+    return queued;
+  }
+  SREG = oldSREG;
+
+  if (tone_pin != 255 && tone_pin != _pin) return false;
+  tone_queue_head = tone_queue_tail = 0;
+  freq = 0;
+  toneStart(_pin, setting & ~TONE_REST, toggles);
+  toneSilence(setting & TONE_REST);
+  return true;
+}
+
+bool toneQueue(uint8_t _pin, unsigned long frequency, unsigned long duration)
+{
+  if (frequency == 0)
+  {
+    return toneQueueSetting(_pin, TONE_REST_SETTING, duration);
+  }
+  return toneQueueSetting(_pin, toneSettingForCycles(TONE_TIMER_CLOCK / frequency / 2), (2 * frequency * duration) / 1000);
+}
+
+bool toneQueueNote(uint8_t _pin, uint8_t note, unsigned long duration)
+{
+  if (note < TONE_NOTE_FIRST || note > TONE_NOTE_LAST)
+  {
+    return toneQueueSetting(_pin, TONE_REST_SETTING, duration);
+  }
+  tone_setting setting = pgm_read_dword(&tone_note_table[note - TONE_NOTE_FIRST]);
+  return toneQueueSetting(_pin, setting, toneNoteToggles(note, duration));
+}
+
+uint8_t toneQueueRoom(void)
+{
+  return (uint8_t)(tone_queue_tail - tone_queue_head - 1) & TONE_QUEUE_MASK;
+}
+
 #if (TIMER_TO_USE_FOR_TONE == 0)
   ISR(TIMER0_COMPA_vect)
 #elif (TIMER_TO_USE_FOR_TONE == 1)
@@ -592,6 +834,9 @@ void noTone( uint8_t _pin )
 
       if ( tone_timer_toggle_count == 0 )
       {
+        // Next note, if toneQueue() has one for us
+        if ( tone_next && tone_next() ) return;
+
         // Shutdown the hardware
         noTone( 255 );
 
@@ -599,7 +844,11 @@ void noTone( uint8_t _pin )
         return;
       }
     }
-    *tone_timer_pin_register ^= tone_timer_pin_mask;
+    // The OCxA/OCxB pins are toggled by the timer, this only counts for them
+    if ( tone_timer_pin_register != NULL )
+    {
+      *tone_timer_pin_register ^= tone_timer_pin_mask;
+    }
   }
   else
   {
@@ -0,0 +1,118 @@
+/*
+  WInterrupts_pcint.h - pin change interrupt dispatcher for one port
+  Part of ATTinyCore
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General
+  Public License along with this library; if not, write to the
+  Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+  Boston, MA  02111-1307  USA
+
+  Not a real header: WInterrupts_pcint0.c to WInterrupts_pcint3.c each
+  include it with PCINT_N, PCINT_PIN, PCINT_PCMSK and (unless the port shares
+  another port's vector) PCINT_VECT defined from the PCINT_PORTn_ macros in
+  pins_arduino.h.  That way each port is its own object file, and only the
+  ports which attachPinChangeInterrupt() is used on end up in the sketch -
+  everyone else is still free to write their own ISR(PCINTn_vect).
+*/
+
+#define PCINT_PASTE_(a, b) a##b
+#define PCINT_PASTE(a, b) PCINT_PASTE_(a, b)
+#define PCINT_NAME(name) PCINT_PASTE(name, PCINT_N)
+
+static volatile voidFuncPtr pcint_func[8];
+static volatile uint8_t pcint_rising;  // bits to call pcint_func for on a rising edge
+static volatile uint8_t pcint_falling; // ... and on a falling one
+static uint8_t pcint_last;             // PINx as of the last interrupt
+
+#if !defined(PCINT_VECT)
+// The vector lives with the other port, calling this pulls it in
+void PCINT_PASTE(_pcintVector, PCINT_SHARED_N)(void);
+#endif
+
+void PCINT_NAME(_attachPinChangeInterrupt)(uint8_t bit, voidFuncPtr func, uint8_t mode)
+{
+  uint8_t mask = _BV(bit);
+  uint8_t oldSREG = SREG;
+  cli();
+  pcint_func[bit] = func;
+  if (mode == RISING || mode == CHANGE) {
+    pcint_rising |= mask;
+  } else {
+    pcint_rising &= ~mask;
+  }
+  if (mode == FALLING || mode == CHANGE) {
+    pcint_falling |= mask;
+  } else {
+    pcint_falling &= ~mask;
+  }
+  // Start from the level the pin is at now, not whatever it was last time
+  pcint_last = (pcint_last & ~mask) | (PCINT_PIN & mask);
+  PCINT_PCMSK |= mask;
+  SREG = oldSREG;
+  #if !defined(PCINT_VECT)
+  PCINT_PASTE(_pcintVector, PCINT_SHARED_N)();
+  #endif
+}
+
+void PCINT_NAME(_detachPinChangeInterrupt)(uint8_t bit)
+{
+  uint8_t mask = _BV(bit);
+  uint8_t oldSREG = SREG;
+  cli();
+  PCINT_PCMSK &= ~mask;
+  pcint_rising &= ~mask;
+  pcint_falling &= ~mask;
+  SREG = oldSREG;
+}
+
+// One XOR against the last snapshot finds every pin which changed, and only
+// those with a callback for the direction they went in get called.
+static inline void pcint_dispatch(void) __attribute__((always_inline));
+static inline void pcint_dispatch(void)
+{
+  uint8_t now = PCINT_PIN;
+  uint8_t changed = (now ^ pcint_last) & PCINT_PCMSK;
+  pcint_last = now;
+  uint8_t fire = changed & ((now & pcint_rising) | (~now & pcint_falling));
+  volatile voidFuncPtr *func = pcint_func;
+  while (fire) {
+    if (fire & 1) (*func)();
+    func++;
+    fire >>= 1;
+  }
+}
+
+#if defined(PCINT_VECT)
+#if defined(PCINT_SHARED_N)
+// The other port on this vector, if it is in use at all
+void PCINT_PASTE(_pcintDispatch, PCINT_SHARED_N)(void) __attribute__((weak));
+
+void PCINT_NAME(_pcintVector)(void)
+{
+}
+#endif
+
+ISR(PCINT_VECT)
+{
+  pcint_dispatch();
+  #if defined(PCINT_SHARED_N)
+  if (PCINT_PASTE(_pcintDispatch, PCINT_SHARED_N))
+    PCINT_PASTE(_pcintDispatch, PCINT_SHARED_N)();
+  #endif
+}
+#else
+void PCINT_NAME(_pcintDispatch)(void)
+{
+  pcint_dispatch();
+}
+#endif
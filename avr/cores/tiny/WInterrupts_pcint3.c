@@ -0,0 +1,35 @@
+/*
+  WInterrupts_pcint3.c - pin change interrupts on port 3, see WInterrupts_pcint.h
+  Part of ATTinyCore
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General
+  Public License along with this library; if not, write to the
+  Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+  Boston, MA  02111-1307  USA
+*/
+
+#include "wiring_private.h"
+#include "pins_arduino.h"
+
+#if defined(PCINT_PORT3_PCMSK)
+  #define PCINT_N     3
+  #define PCINT_PIN   PCINT_PORT3_PIN
+  #define PCINT_PCMSK PCINT_PORT3_PCMSK
+  #if defined(PCINT_PORT3_VECT)
+    #define PCINT_VECT PCINT_PORT3_VECT
+  #endif
+  #if defined(PCINT_PORT3_SHARES)
+    #define PCINT_SHARED_N PCINT_PORT3_SHARES
+  #endif
+  #include "WInterrupts_pcint.h"
+#endif
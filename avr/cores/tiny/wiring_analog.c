@@ -45,22 +45,6 @@ void analogReference(uint8_t mode)
   analog_reference = mode;
 }
 
-#if defined(REFS1)
-#define ADMUX_REFS_MASK (0x03)
-#else
-#define ADMUX_REFS_MASK (0x01)
-#endif
-
-#if defined(MUX5)
-#define ADMUX_MUX_MASK (0x3f)
-#elif defined(MUX4)
-#define ADMUX_MUX_MASK (0x1f)
-#elif defined(MUX3)
-#define ADMUX_MUX_MASK (0x0f)
-#else
-#define ADMUX_MUX_MASK (0x07)
-#endif
-
 uint16_t _analogRead(uint8_t pin)
 {
   // This has been stripped off already by analogRead() in Arduino.h
@@ -72,38 +56,42 @@ uint16_t _analogRead(uint8_t pin)
   (void)pin; // Silence warning about pin not being used
   return 0;
 #else
-  #if defined(REFS0)
-  #if defined(ADMUX)
-  ADMUX = ((analog_reference & ADMUX_REFS_MASK) << REFS0) | ((pin & ADMUX_MUX_MASK) << MUX0); //select the channel and reference
-  #if defined(REFS2)
-  ADMUX |= (((analog_reference & 0x04) >> 2) << REFS2); //some have an extra reference bit in a weird position.
-  #endif
-  #endif
-  #else
-    // Chips without any other reference than Vcc
-    ADMUX = pin;
-  #endif
+  _analogSetChannel(pin); //select the channel and reference
   
   #if defined(HAVE_ADC) && HAVE_ADC
   sbi(ADCSRA, ADSC); //Start conversion
 
   while(ADCSRA & (1<<ADSC)); //Wait for conversion to complete.
 
-  uint8_t low = ADCL;
-#if defined(ADCH)
-  uint8_t high = ADCH;
-  return (high << 8) | low;
-#else
-  // Some chips only have 8 bit ADC, because everything written mostly assumes 10 bit
-  // we will multiply by 4 before we return it
-  return low << 2;
-#endif
+  return _analogResult();
   #else
   return LOW;
   #endif
 #endif
 }
 
+#if defined(HAVE_ADC) && HAVE_ADC && defined(ADCSRA)
+// Oversample and decimate: every extra bit of resolution takes four times as
+// many samples, which are summed and the sum shifted right by the number of
+// extra bits.  This only works if there is at least an LSB or so of noise on
+// the signal for the samples to differ by, so it gains less in ADC noise
+// reduction mode than it does with plain conversions.
+uint16_t _analogOversample(uint8_t pin, uint8_t bits, uint16_t (*convert)(uint8_t))
+{
+  if (bits <= 10) return convert(pin);
+  if (bits > 16) bits = 16;
+  uint8_t extra = bits - 10;
+
+  uint32_t sum = 0;
+  uint16_t samples = 1 << (extra * 2);
+  do {
+    sum += convert(pin);
+  } while (--samples);
+
+  return sum >> extra;
+}
+#endif
+
 // Right now, PWM output only works on the pins with
 // hardware support.  These are defined in the appropriate
 // pins_*.c file.  For the rest of the pins, we default
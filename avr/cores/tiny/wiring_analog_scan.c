@@ -0,0 +1,195 @@
+/*
+  wiring_analog_scan.c - interrupt driven ADC scanning and noise reduction
+  Part of ATTinyCore
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General
+  Public License along with this library; if not, write to the
+  Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+  Boston, MA  02111-1307  USA
+
+  The scanner converts a list of channels one after the other from the ADC
+  interrupt, see analogScanBegin() in Arduino.h for how to use it.
+  analogReadNoiseReduced() needs the same interrupt to wake from ADC noise
+  reduction sleep, so it lives here too.
+
+  This is in its own file (and not wiring_analog.c) so that the ADC
+  interrupt, and the RAM for the results, only end up in sketches which
+  actually use them; everyone else is free to define ISR(ADC_vect)
+  themselves.
+*/
+
+#include <avr/sleep.h>
+
+#include "wiring_private.h"
+#include "pins_arduino.h"
+
+#if defined(HAVE_ADC) && HAVE_ADC && defined(ADCSRA) && defined(ADC_vect)
+
+#ifndef ANALOG_SCAN_BUFFER_SIZE
+  #if (RAMEND < 512)
+    #define ANALOG_SCAN_BUFFER_SIZE 4
+  #else
+    #define ANALOG_SCAN_BUFFER_SIZE 8
+  #endif
+#endif
+
+#if (ANALOG_SCAN_BUFFER_SIZE & (ANALOG_SCAN_BUFFER_SIZE - 1)) || ANALOG_SCAN_BUFFER_SIZE > 128
+  #error "ANALOG_SCAN_BUFFER_SIZE must be a power of two, no bigger than 128"
+#endif
+
+#define ANALOG_SCAN_BUFFER_MASK (ANALOG_SCAN_BUFFER_SIZE - 1)
+
+static const uint8_t * volatile scan_channels;
+static volatile uint8_t scan_count;
+static volatile uint8_t scan_next;     // index in scan_channels of the conversion in progress
+static volatile uint8_t scan_mode;     // ANALOG_SCAN_ONCE, ANALOG_SCAN_CONTINUOUS, or 0 when stopped
+static volatile analogScanCallback scan_callback;
+
+// Results waiting for analogScanRead(), the interrupt only moves head and
+// analogScanRead() only moves tail, so neither needs to turn off interrupts.
+static uint16_t scan_values[ANALOG_SCAN_BUFFER_SIZE];
+static uint8_t  scan_indexes[ANALOG_SCAN_BUFFER_SIZE];
+static volatile uint8_t scan_head;
+static volatile uint8_t scan_tail;
+
+void analogScanBegin(const uint8_t *channels, uint8_t count, uint8_t mode)
+{
+  analogScanEnd();
+  if (count == 0) return;
+
+  scan_channels = channels;
+  scan_count    = count;
+  scan_next     = 0;
+  scan_mode     = mode;
+  scan_head     = scan_tail = 0;
+
+  // Analog pin numbers have the top bit set, as for analogRead()
+  _analogSetChannel(channels[0] & 0x7F);
+
+  // Writing ADIF clears any stale flag left over from analogRead()
+  ADCSRA |= _BV(ADIF) | _BV(ADIE) | _BV(ADSC);
+}
+
+void analogScanEnd(void)
+{
+  cbi(ADCSRA, ADIE);
+  scan_mode = 0;
+
+  // Let a conversion we already started finish, so that the next
+  // analogRead() does not get its result.
+  while (ADCSRA & _BV(ADSC));
+}
+
+uint8_t analogScanRunning(void)
+{
+  return scan_mode != 0;
+}
+
+uint8_t analogScanAvailable(void)
+{
+  return (uint8_t)(scan_head - scan_tail) & ANALOG_SCAN_BUFFER_MASK;
+}
+
+int analogScanRead(uint8_t *index)
+{
+  uint8_t tail = scan_tail;
+  if (tail == scan_head) return -1;
+
+  if (index) *index = scan_indexes[tail];
+  uint16_t value = scan_values[tail];
+  scan_tail = (tail + 1) & ANALOG_SCAN_BUFFER_MASK;
+  return value;
+}
+
+void analogScanAttach(analogScanCallback callback)
+{
+  scan_callback = callback;
+}
+
+#if defined(SLEEP_MODE_ADC)
+uint16_t analogReadNoiseReduced(uint8_t pin)
+{
+  _analogSetChannel(pin & 0x7F);
+
+  uint8_t oldSREG = SREG;
+  uint8_t oldSleep = _SLEEP_CONTROL_REG;
+
+  ADCSRA |= _BV(ADIF) | _BV(ADIE);
+  set_sleep_mode(SLEEP_MODE_ADC);
+  sleep_enable();
+  sei();
+
+  // Going to sleep starts the conversion, the ADC interrupt wakes us when
+  // it's done, but so does any other interrupt (millis, serial...) in which
+  // case the conversion is still running and we go back to sleep.
+  do {
+    sleep_cpu();
+  } while (ADCSRA & _BV(ADSC));
+
+  cli();
+  _SLEEP_CONTROL_REG = oldSleep;
+  cbi(ADCSRA, ADIE);
+  SREG = oldSREG;
+
+  return _analogResult();
+}
+#endif
+
+ISR(ADC_vect)
+{
+  // We only woke analogReadNoiseReduced()
+  if (!scan_mode) return;
+
+  uint16_t value = _analogResult();
+
+  // Start the next conversion before doing anything with this one, so the
+  // ADC is not left idle while we run the callback.
+  uint8_t index = scan_next;
+  uint8_t next  = index + 1;
+  if (next == scan_count)
+  {
+    next = 0;
+    if (scan_mode != ANALOG_SCAN_CONTINUOUS)
+    {
+      cbi(ADCSRA, ADIE);
+      scan_mode = 0;
+    }
+  }
+  scan_next = next;
+
+  if (scan_mode)
+  {
+    _analogSetChannel(scan_channels[next] & 0x7F);
+    sbi(ADCSRA, ADSC);
+  }
+
+  analogScanCallback callback = scan_callback;
+  if (callback)
+  {
+    callback(index, value);
+    return;
+  }
+
+  // If the sketch is not keeping up we drop the new result rather than
+  // overwrite ones it has not read yet.
+  uint8_t head = scan_head;
+  uint8_t newHead = (head + 1) & ANALOG_SCAN_BUFFER_MASK;
+  if (newHead != scan_tail)
+  {
+    scan_values[head]  = value;
+    scan_indexes[head] = index;
+    scan_head = newHead;
+  }
+}
+
+#endif
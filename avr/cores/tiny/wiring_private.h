@@ -47,65 +47,7 @@ extern "C"{
 
 uint32_t countPulseASM(volatile uint8_t *port, uint8_t bit, uint8_t stateMask, unsigned long maxloops);
 
-#if defined( EXT_INT0_vect )
-  #define EXTERNAL_INTERRUPT_0_vect EXT_INT0_vect
-#elif defined( INT0_vect )
-  #define EXTERNAL_INTERRUPT_0_vect INT0_vect
-#endif
-
-#if defined( EXT_INT1_vect )
-  #define EXTERNAL_INTERRUPT_1_vect EXT_INT1_vect
-#elif defined( INT1_vect )
-  #define EXTERNAL_INTERRUPT_1_vect INT1_vect
-#endif
-
-#if defined( EXT_INT2_vect )
-  #define EXTERNAL_INTERRUPT_2_vect EXT_INT2_vect
-#elif defined( INT2_vect )
-  #define EXTERNAL_INTERRUPT_2_vect INT2_vect
-#endif
-
-#if defined( EXT_INT3_vect )
-  #define EXTERNAL_INTERRUPT_3_vect EXT_INT3_vect
-#elif defined( INT3_vect )
-  #define EXTERNAL_INTERRUPT_3_vect INT3_vect
-#endif
-
-#if defined( EXT_INT4_vect )
-  #define EXTERNAL_INTERRUPT_4_vect EXT_INT4_vect
-#elif defined( INT4_vect )
-  #define EXTERNAL_INTERRUPT_4_vect INT4_vect
-#endif
-
-#if defined( EXT_INT5_vect )
-  #define EXTERNAL_INTERRUPT_5_vect EXT_INT5_vect
-#elif defined( INT5_vect )
-  #define EXTERNAL_INTERRUPT_5_vect INT5_vect
-#endif
-
-#if defined( EXT_INT6_vect )
-  #define EXTERNAL_INTERRUPT_6_vect EXT_INT6_vect
-#elif defined( INT6_vect )
-  #define EXTERNAL_INTERRUPT_6_vect INT6_vect
-#endif
-
-#if defined( EXT_INT7_vect )
-  #define EXTERNAL_INTERRUPT_7_vect EXT_INT7_vect
-#elif defined( INT7_vect )
-  #define EXTERNAL_INTERRUPT_7_vect INT7_vect
-#endif
-
-#if defined( EXT_INT8_vect )
-  #define EXTERNAL_INTERRUPT_8_vect EXT_INT8_vect
-#elif defined( INT8_vect )
-  #define EXTERNAL_INTERRUPT_8_vect INT8_vect
-#endif
-
-#if defined( EXT_INT9_vect )
-  #define EXTERNAL_INTERRUPT_9_vect EXT_INT9_vect
-#elif defined( INT9_vect )
-  #define EXTERNAL_INTERRUPT_9_vect INT9_vect
-#endif
+// The EXTERNAL_INTERRUPT_n_vect names are in Arduino.h, as FAST_INTERRUPT() needs them too.
 
 #if defined( EXTERNAL_INTERRUPT_9_vect )
   #define NUMBER_EXTERNAL_INTERRUPTS (10)
@@ -173,6 +115,66 @@ uint32_t countPulseASM(volatile uint8_t *port, uint8_t bit, uint8_t stateMask, u
 
 typedef void (*voidFuncPtr)(void);
 
+#if defined(ADMUX)
+extern uint8_t analog_reference;
+
+#if defined(REFS1)
+#define ADMUX_REFS_MASK (0x03)
+#else
+#define ADMUX_REFS_MASK (0x01)
+#endif
+
+// On the x61 MUX5 and REFS2 are not in ADMUX at all but in ADCSRB, along
+// with GSEL which picks the gain of the differential channels.
+#if defined(__AVR_ATtinyX61__)
+#define ADMUX_MUX_MASK (0x1f)
+#elif defined(MUX5)
+#define ADMUX_MUX_MASK (0x3f)
+#elif defined(MUX4)
+#define ADMUX_MUX_MASK (0x1f)
+#elif defined(MUX3)
+#define ADMUX_MUX_MASK (0x0f)
+#else
+#define ADMUX_MUX_MASK (0x07)
+#endif
+
+// Point the ADC at the given channel (the MUX number, as analogRead() gets
+// it) using the current analog_reference, shared by analogRead() and the
+// interrupt driven scanner in wiring_analog_scan.c
+static inline void _analogSetChannel(uint8_t channel) __attribute__((always_inline, unused));
+static inline void _analogSetChannel(uint8_t channel)
+{
+  #if defined(REFS0)
+  ADMUX = ((analog_reference & ADMUX_REFS_MASK) << REFS0) | ((channel & ADMUX_MUX_MASK) << MUX0); //select the channel and reference
+  #if defined(__AVR_ATtinyX61__)
+  ADCSRB = (ADCSRB & ~(_BV(GSEL) | _BV(REFS2) | _BV(MUX5)))
+         | ((channel & 0x20) ? _BV(MUX5) : 0)
+         | ((channel & 0x40) ? _BV(GSEL) : 0) // ADC_HIGH_GAIN()
+         | ((analog_reference & 0x04) ? _BV(REFS2) : 0);
+  #elif defined(REFS2)
+  ADMUX |= (((analog_reference & 0x04) >> 2) << REFS2); //some have an extra reference bit in a weird position.
+  #endif
+  #else
+    // Chips without any other reference than Vcc
+    ADMUX = channel;
+  #endif
+}
+
+// The result of the last conversion, scaled to 10 bits on chips which only
+// have an 8 bit ADC (because everything written mostly assumes 10 bit)
+static inline uint16_t _analogResult(void) __attribute__((always_inline, unused));
+static inline uint16_t _analogResult(void)
+{
+  uint8_t low = ADCL;
+  #if defined(ADCH)
+  uint8_t high = ADCH;
+  return (high << 8) | low;
+  #else
+  return low << 2;
+  #endif
+}
+#endif
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
@@ -0,0 +1,192 @@
+/*
+  wiring_pulse_capture.c - pulse measurement with the Timer1 input capture unit
+  Part of ATTinyCore
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General
+  Public License along with this library; if not, write to the
+  Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+  Boston, MA  02111-1307  USA
+
+  pulseIn() counts loop iterations, so it ties up the CPU and every
+  interrupt during the pulse makes it read short.  Here the edges on the
+  ICP1 pin are timestamped by the hardware instead: Timer1 runs undivided
+  in normal mode, the overflow interrupt extends it to 32 bits, and the
+  capture interrupt flips the edge it waits for after each one.  So the
+  interrupt latency only matters if it is longer than the next pulse.
+
+  While a measurement is running Timer1 belongs to it (no PWM on its pins,
+  no tone()), and its registers are put back when it ends.  This is in its
+  own file so the two interrupts are only linked in if it is used.
+*/
+
+#include "wiring_private.h"
+#include "pins_arduino.h"
+
+#if defined(ICR1) && (TIMER_TO_USE_FOR_MILLIS != 1)
+
+#if !defined(TIMER1_CAPT_vect) && defined(TIM1_CAPT_vect)
+  #define TIMER1_CAPT_vect TIM1_CAPT_vect
+#endif
+#if !defined(TIMER1_OVF_vect) && defined(TIM1_OVF_vect)
+  #define TIMER1_OVF_vect TIM1_OVF_vect
+#endif
+
+#if defined(TIMSK1)
+  #define CAPTURE_TIMSK TIMSK1
+  #define CAPTURE_TIFR  TIFR1
+#else
+  #define CAPTURE_TIMSK TIMSK
+  #define CAPTURE_TIFR  TIFR
+#endif
+
+// The timestamps are in clock cycles, which can run to 32 bits, more than the
+// * 1000 in some versions of clockCyclesToMicroseconds() has room for.
+#if F_CPU >= 1000000UL
+  #define CAPTURE_TICKS_TO_US(t) ((t) / (F_CPU / 1000000UL))
+  #define CAPTURE_US_TO_TICKS(t) ((t) * (F_CPU / 1000000UL))
+#else
+  #define CAPTURE_TICKS_TO_US(t) ((t) * (1000000UL / F_CPU))
+  #define CAPTURE_US_TO_TICKS(t) ((t) / (1000000UL / F_CPU))
+#endif
+
+static volatile uint16_t capture_overflows; // top half of the 32 bit timestamp
+static uint32_t capture_last;               // timestamp of the previous edge
+static volatile uint32_t capture_width;     // the pulse, for a single one
+static uint16_t * volatile capture_train;
+static volatile uint8_t capture_count;      // widths wanted
+static volatile uint8_t capture_done;       // widths recorded
+static volatile uint8_t capture_started;    // seen the edge the first pulse starts on
+static uint8_t capture_saved_a, capture_saved_b, capture_saved_mask;
+static uint8_t capture_running;
+
+static void captureArm(uint8_t state, uint16_t *train, uint8_t count)
+{
+  if (!capture_running) {
+    capture_saved_a    = TCCR1A;
+    capture_saved_b    = TCCR1B;
+    capture_saved_mask = CAPTURE_TIMSK;
+    capture_running    = 1;
+  }
+  uint8_t oldSREG = SREG;
+  cli();
+  capture_train     = train;
+  capture_count     = count;
+  capture_done      = 0;
+  capture_started   = 0;
+  capture_width     = 0;
+  capture_overflows = 0;
+  TCCR1A = 0;
+  // Normal mode, no prescaler, first edge is the one the pulse starts on
+  TCCR1B = (state ? _BV(ICES1) : 0) | _BV(CS10);
+  TCNT1  = 0;
+  CAPTURE_TIFR  = _BV(ICF1) | _BV(TOV1);
+  CAPTURE_TIMSK = (CAPTURE_TIMSK & ~(_BV(OCIE1A) | _BV(OCIE1B))) | _BV(ICIE1) | _BV(TOIE1);
+  SREG = oldSREG;
+}
+
+void pulseInNonBlocking(uint8_t state, uint16_t *train, uint8_t count)
+{
+  if (count == 0) count = 1;
+  captureArm(state, train, count);
+}
+
+uint8_t pulseInAvailable(void)
+{
+  return capture_done;
+}
+
+unsigned long pulseInResult(void)
+{
+  uint8_t oldSREG = SREG;
+  cli();
+  uint32_t ticks = capture_width;
+  SREG = oldSREG;
+  return CAPTURE_TICKS_TO_US(ticks);
+}
+
+void pulseInStop(void)
+{
+  if (!capture_running) return;
+  uint8_t oldSREG = SREG;
+  cli();
+  CAPTURE_TIMSK = capture_saved_mask;
+  TCCR1A = capture_saved_a;
+  TCCR1B = capture_saved_b;
+  SREG = oldSREG;
+  capture_running = 0;
+}
+
+unsigned long pulseInCapture(uint8_t state, unsigned long timeout)
+{
+  captureArm(state, NULL, 1);
+
+  // The timeout is kept in timer overflows, so it needs neither millis()
+  // nor interrupts to be as they were.
+  uint32_t limit = (CAPTURE_US_TO_TICKS(timeout) >> 16) + 1;
+  if (limit > 0xFFFF) limit = 0xFFFF;
+  unsigned long width = 0;
+  for (;;) {
+    if (capture_done) {
+      width = pulseInResult();
+      break;
+    }
+    uint8_t oldSREG = SREG;
+    cli();
+    uint16_t overflows = capture_overflows;
+    SREG = oldSREG;
+    if (overflows >= limit) break;
+  }
+  pulseInStop();
+  return width;
+}
+
+ISR(TIMER1_OVF_vect)
+{
+  capture_overflows++;
+}
+
+ISR(TIMER1_CAPT_vect)
+{
+  uint16_t icr = ICR1;
+  uint16_t high = capture_overflows;
+  // If the timer overflowed after this capture but before we got here, the
+  // overflow interrupt has not run yet, so only count it if the capture
+  // came after it.
+  if ((CAPTURE_TIFR & _BV(TOV1)) && !(icr & 0x8000)) high++;
+  uint32_t now = ((uint32_t)high << 16) | icr;
+
+  // Wait for the other edge next.  Changing ICES1 can set ICF1, which has to
+  // be cleared.
+  TCCR1B ^= _BV(ICES1);
+  CAPTURE_TIFR = _BV(ICF1);
+
+  if (!capture_started) {
+    capture_started = 1;
+  } else {
+    uint32_t ticks = now - capture_last;
+    uint8_t done = capture_done;
+    if (capture_train) {
+      uint32_t us = CAPTURE_TICKS_TO_US(ticks);
+      capture_train[done] = (us > 0xFFFF) ? 0xFFFF : us;
+    } else {
+      capture_width = ticks;
+    }
+    capture_done = ++done;
+    if (done == capture_count) {
+      cbi(CAPTURE_TIMSK, ICIE1);
+    }
+  }
+  capture_last = now;
+}
+
+#endif
@@ -1,5 +1,5 @@
 /*
-  wiring_shift.c - shiftOut() function
+  wiring_shift.c - shiftOut(), shiftOutBuffer() and shiftIn()
   Part of Arduino - http://www.arduino.cc/
 
   Copyright (c) 2005-2006 David A. Mellis
@@ -23,33 +23,146 @@
 */
 
 #include "wiring_private.h"
+#include "pins_arduino.h"
 
+static uint8_t reverseBits(uint8_t x)
+{
+  uint8_t r = 0;
+  for (uint8_t i = 8; i; i--) {
+    r = (r << 1) | (x & 1);
+    x >>= 1;
+  }
+  return r;
+}
+
+// When the pins are the USI's DO (or DI) and USCK, the USI shifts the byte
+// out at half the clock speed.  Not on the x7, where MOSI/SCK are the SPI pins.
+#if defined(USICR) && !defined(SPCR) && defined(MOSI) && defined(SCK)
+  #define SHIFT_USE_USI 1
+
+// Software strobed three wire mode, as SPI mode 0: DO changes on the falling
+// edge of USCK and DI is sampled on the rising one.  USICR is put back after,
+// so the pins are left to the PORT registers (or to the SPI library) again.
+static uint8_t usiShift(uint8_t val)
+{
+  uint8_t strobe1 = _BV(USIWM0) | _BV(USITC);
+  uint8_t strobe2 = _BV(USIWM0) | _BV(USITC) | _BV(USICLK);
+  uint8_t usicr = USICR;
+  USISR = _BV(USIOIF);
+  USIDR = val;
+  asm volatile("out %[usicr], %[strobe1] \n\t"
+               "out %[usicr], %[strobe2] \n\t"
+               "out %[usicr], %[strobe1] \n\t"
+               "out %[usicr], %[strobe2] \n\t"
+               "out %[usicr], %[strobe1] \n\t"
+               "out %[usicr], %[strobe2] \n\t"
+               "out %[usicr], %[strobe1] \n\t"
+               "out %[usicr], %[strobe2] \n\t"
+               "out %[usicr], %[strobe1] \n\t"
+               "out %[usicr], %[strobe2] \n\t"
+               "out %[usicr], %[strobe1] \n\t"
+               "out %[usicr], %[strobe2] \n\t"
+               "out %[usicr], %[strobe1] \n\t"
+               "out %[usicr], %[strobe2] \n\t"
+               "out %[usicr], %[strobe1] \n\t"
+               "out %[usicr], %[strobe2] \n\t"
+               :
+               : [usicr] "I" (_SFR_IO_ADDR(USICR)),
+                 [strobe1] "r" (strobe1),
+                 [strobe2] "r" (strobe2));
+  val = USIDR;
+  USICR = usicr;
+  return val;
+}
+#endif
+
+// Otherwise the ports and masks are looked up once, and the pins are toggled
+// by writing their bit to PINx, which is a single (so atomic) write and does
+// not need interrupts turned off around a read-modify-write of PORTx.
 uint8_t shiftIn(uint8_t dataPin, uint8_t clockPin, uint8_t bitOrder) {
+  if (dataPin & 128) dataPin = analogInputToDigitalPin(dataPin & 127);
+  if (clockPin & 128) clockPin = analogInputToDigitalPin(clockPin & 127);
+
+  #if SHIFT_USE_USI
+  if (dataPin == MISO && clockPin == SCK) {
+    uint8_t value = usiShift(0);
+    return (bitOrder == LSBFIRST) ? reverseBits(value) : value;
+  }
+  #endif
+
+  uint8_t dataPort = digitalPinToPort(dataPin);
+  uint8_t clockPort = digitalPinToPort(clockPin);
+  if (dataPort == NOT_A_PIN || clockPort == NOT_A_PIN) return 0;
+
+  volatile uint8_t *dataIn = portInputRegister(dataPort);
+  volatile uint8_t *clockToggle = portInputRegister(clockPort);
+  uint8_t dataBit = digitalPinToBitMask(dataPin);
+  uint8_t clockBit = digitalPinToBitMask(clockPin);
+
+  digitalWrite(clockPin, LOW);
+
   uint8_t value = 0;
-  uint8_t i;
-
-  for (i = 0; i < 8; ++i) {
-    digitalWrite(clockPin, HIGH);
-    if (bitOrder == LSBFIRST)
-      value |= digitalRead(dataPin) << i;
-    else
-      value |= digitalRead(dataPin) << (7 - i);
-    digitalWrite(clockPin, LOW);
+  for (uint8_t i = 8; i; i--) {
+    *clockToggle = clockBit; // HIGH
+    if (bitOrder == LSBFIRST) {
+      value >>= 1;
+      if (*dataIn & dataBit) value |= 0x80;
+    } else {
+      value <<= 1;
+      if (*dataIn & dataBit) value |= 0x01;
+    }
+    *clockToggle = clockBit; // LOW
   }
   return value;
 }
 
-void shiftOut(uint8_t dataPin, uint8_t clockPin, uint8_t bitOrder, uint8_t val)
+void shiftOutBuffer(uint8_t dataPin, uint8_t clockPin, uint8_t bitOrder, const uint8_t *buffer, uint16_t length)
 {
-  uint8_t i;
+  if (dataPin & 128) dataPin = analogInputToDigitalPin(dataPin & 127);
+  if (clockPin & 128) clockPin = analogInputToDigitalPin(clockPin & 127);
+
+  #if SHIFT_USE_USI
+  if (dataPin == MOSI && clockPin == SCK) {
+    while (length--) {
+      uint8_t val = *buffer++;
+      usiShift(bitOrder == LSBFIRST ? reverseBits(val) : val);
+    }
+    return;
+  }
+  #endif
+
+  uint8_t dataPort = digitalPinToPort(dataPin);
+  uint8_t clockPort = digitalPinToPort(clockPin);
+  if (dataPort == NOT_A_PIN || clockPort == NOT_A_PIN) return;
 
-  for (i = 0; i < 8; i++)  {
-    if (bitOrder == LSBFIRST)
-      digitalWrite(dataPin, !!(val & (1 << i)));
-    else
-      digitalWrite(dataPin, !!(val & (1 << (7 - i))));
+  volatile uint8_t *dataToggle = portInputRegister(dataPort);
+  volatile uint8_t *clockToggle = portInputRegister(clockPort);
+  uint8_t dataBit = digitalPinToBitMask(dataPin);
+  uint8_t clockBit = digitalPinToBitMask(clockPin);
 
-    digitalWrite(clockPin, HIGH);
-    digitalWrite(clockPin, LOW);
+  // Start from a known state (this also turns off PWM on either pin), after
+  // that the data pin is only toggled when the next bit differs.
+  digitalWrite(clockPin, LOW);
+  digitalWrite(dataPin, LOW);
+  uint8_t level = 0;
+
+  while (length--) {
+    uint8_t val = *buffer++;
+    if (bitOrder == LSBFIRST) val = reverseBits(val);
+    for (uint8_t i = 8; i; i--) {
+      uint8_t bit = (val & 0x80) ? dataBit : 0;
+      if (bit != level) {
+        *dataToggle = dataBit;
+        level = bit;
+      }
+      *clockToggle = clockBit; // HIGH
+      *clockToggle = clockBit; // LOW
+      val <<= 1;
+    }
   }
 }
+
+void shiftOut(uint8_t dataPin, uint8_t clockPin, uint8_t bitOrder, uint8_t val)
+{
+  shiftOutBuffer(dataPin, clockPin, bitOrder, &val, 1);
+}
@@ -77,13 +77,6 @@ void serialEventRun(void)
 #endif
 }
 
-// macro to guard critical sections when needed for large TX buffer sizes
-#if (SERIAL_TX_BUFFER_SIZE>256)
-#define TX_BUFFER_ATOMIC ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
-#else
-#define TX_BUFFER_ATOMIC
-#endif
-
 // Actual interrupt handlers //////////////////////////////////////////////////////////////
 
 void HardwareSerial::_tx_udr_empty_irq(void)
@@ -91,7 +84,7 @@ void HardwareSerial::_tx_udr_empty_irq(void)
   // If interrupts are enabled, there must be more data in the output
   // buffer. Send the next byte
   unsigned char c = _tx_buffer[_tx_buffer_tail];
-  _tx_buffer_tail = (_tx_buffer_tail + 1) % SERIAL_TX_BUFFER_SIZE;
+  _tx_buffer_tail = (tx_buffer_index_t)(_tx_buffer_tail + 1) & _tx_buffer_mask;
 
   *_udr = c;
 
@@ -165,7 +158,7 @@ void HardwareSerial::end()
 
 int HardwareSerial::available(void)
 {
-  return ((unsigned int)(SERIAL_RX_BUFFER_SIZE + _rx_buffer_head - _rx_buffer_tail)) % SERIAL_RX_BUFFER_SIZE;
+  return (rx_buffer_index_t)(_rx_buffer_head - _rx_buffer_tail) & _rx_buffer_mask;
 }
 
 int HardwareSerial::peek(void)
@@ -184,22 +177,15 @@ int HardwareSerial::read(void)
     return -1;
   } else {
     unsigned char c = _rx_buffer[_rx_buffer_tail];
-    _rx_buffer_tail = (rx_buffer_index_t)(_rx_buffer_tail + 1) % SERIAL_RX_BUFFER_SIZE;
+    _rx_buffer_tail = (rx_buffer_index_t)(_rx_buffer_tail + 1) & _rx_buffer_mask;
     return c;
   }
 }
 
 int HardwareSerial::availableForWrite(void)
 {
-  tx_buffer_index_t head;
-  tx_buffer_index_t tail;
-
-  TX_BUFFER_ATOMIC {
-    head = _tx_buffer_head;
-    tail = _tx_buffer_tail;
-  }
-  if (head >= tail) return SERIAL_TX_BUFFER_SIZE - 1 - head + tail;
-  return tail - head - 1;
+  if (!_tx_buffer) return bit_is_set(*_ucsra, UDRE0) ? 1 : 0;
+  return _tx_buffer_mask - ((tx_buffer_index_t)(_tx_buffer_head - _tx_buffer_tail) & _tx_buffer_mask);
 }
 
 void HardwareSerial::flush()
@@ -222,33 +208,45 @@ void HardwareSerial::flush()
   // the hardware finished transmission (TXC is set).
 }
 
+void HardwareSerial::_write_udr(uint8_t c)
+{
+  // If TXC is cleared before writing UDR and the previous byte
+  // completes before writing to UDR, TXC will be set but a byte
+  // is still being transmitted causing flush() to return too soon.
+  // So writing UDR must happen first.
+  // Writing UDR and clearing TC must be done atomically, otherwise
+  // interrupts might delay the TXC clear so the byte written to UDR
+  // is transmitted (setting TXC) before clearing TXC. Then TXC will
+  // be cleared when no bytes are left, causing flush() to hang
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    *_udr = c;
+#ifdef MPCM0
+    *_ucsra = ((*_ucsra) & ((1 << U2X0) | (1 << MPCM0))) | (1 << TXC0);
+#else
+    *_ucsra = ((*_ucsra) & ((1 << U2X0) | (1 << TXC0)));
+#endif
+  }
+}
+
 size_t HardwareSerial::write(uint8_t c)
 {
   _written = true;
+  // Unbuffered, wait for the data register and write straight to it.
+  if (!_tx_buffer) {
+    while (bit_is_clear(*_ucsra, UDRE0))
+      ;
+    _write_udr(c);
+    return 1;
+  }
   // If the buffer and the data register is empty, just write the byte
   // to the data register and be done. This shortcut helps
   // significantly improve the effective datarate at high (>
   // 500kbit/s) bitrates, where interrupt overhead becomes a slowdown.
   if (_tx_buffer_head == _tx_buffer_tail && bit_is_set(*_ucsra, UDRE0)) {
-    // If TXC is cleared before writing UDR and the previous byte
-    // completes before writing to UDR, TXC will be set but a byte
-    // is still being transmitted causing flush() to return too soon.
-    // So writing UDR must happen first.
-    // Writing UDR and clearing TC must be done atomically, otherwise
-    // interrupts might delay the TXC clear so the byte written to UDR
-    // is transmitted (setting TXC) before clearing TXC. Then TXC will
-    // be cleared when no bytes are left, causing flush() to hang
-    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
-      *_udr = c;
-#ifdef MPCM0
-      *_ucsra = ((*_ucsra) & ((1 << U2X0) | (1 << MPCM0))) | (1 << TXC0);
-#else
-      *_ucsra = ((*_ucsra) & ((1 << U2X0) | (1 << TXC0)));
-#endif
-    }
+    _write_udr(c);
     return 1;
   }
-  tx_buffer_index_t i = (_tx_buffer_head + 1) % SERIAL_TX_BUFFER_SIZE;
+  tx_buffer_index_t i = (tx_buffer_index_t)(_tx_buffer_head + 1) & _tx_buffer_mask;
 
   // If the output buffer is full, there's nothing for it other than to
   // wait for the interrupt handler to empty it a bit
@@ -278,4 +276,38 @@ size_t HardwareSerial::write(uint8_t c)
   return 1;
 }
 
+size_t HardwareSerial::write(const uint8_t *buffer, size_t size)
+{
+  if (!_tx_buffer)
+    return Print::write(buffer, size);
+
+  _written = true;
+  size_t left = size;
+  while (left) {
+    // Copy as much as fits each time round, then publish it and kick the
+    // interrupt once for the whole chunk rather than once for every byte.
+    tx_buffer_index_t head = _tx_buffer_head;
+    tx_buffer_index_t room = _tx_buffer_mask - ((tx_buffer_index_t)(head - _tx_buffer_tail) & _tx_buffer_mask);
+    if (!room) {
+      // Full, as in write(uint8_t) poll the data register empty flag
+      // ourselves if interrupts are disabled.
+      if (bit_is_clear(SREG, SREG_I) && bit_is_set(*_ucsra, UDRE0))
+        _tx_udr_empty_irq();
+      continue;
+    }
+    if (room > left) room = left;
+    left -= room;
+    do {
+      _tx_buffer[head] = *buffer++;
+      head = (tx_buffer_index_t)(head + 1) & _tx_buffer_mask;
+    } while (--room);
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+      _tx_buffer_head = head;
+      sbi(*_ucsrb, UDRIE0);
+    }
+  }
+  return size;
+}
+
 #endif // whole file
@@ -28,17 +28,16 @@
 
 #include "Stream.h"
 
-// Define constants and variables for buffering incoming serial data.  We're
-// using a ring buffer (I think), in which head is the index of the location
-// to which to write the next incoming character and tail is the index of the
-// location from which to read.
-// NOTE: a "power of 2" buffer size is recommended to dramatically
-//       optimize all the modulo operations for ring buffers.
-// WARNING: When buffer sizes are increased to > 256, the buffer index
-// variables are automatically increased in size, but the extra
-// atomicity guards needed for that are not implemented. This will
-// often work, but occasionally a race condition can occur that makes
-// Serial behave erratically. See https://github.com/arduino/Arduino/issues/2405
+// Sizes of the receive and transmit buffers of each port.  Head is the index
+// of the location to which to write the next character and tail the index of
+// the location from which to read; they wrap with a mask, so the sizes must
+// be powers of two from 2 to 256.  A transmit buffer size of 0 means no
+// buffer at all, write() waits for the data register to be free and writes
+// straight to it.
+//
+// SERIAL_RX/TX_BUFFER_SIZE are for Serial, SERIAL1_RX/TX_BUFFER_SIZE for
+// Serial1 (default: the same as Serial).  They are set by the Tools -> Serial
+// Buffers menus, or can be passed as -D options in the build flags.
 #if !defined(SERIAL_TX_BUFFER_SIZE)
 #if ((RAMEND - RAMSTART) < 1023)
 #define SERIAL_TX_BUFFER_SIZE 16
@@ -53,17 +52,16 @@
 #define SERIAL_RX_BUFFER_SIZE 32
 #endif
 #endif
-#if (SERIAL_TX_BUFFER_SIZE>256)
-typedef uint16_t tx_buffer_index_t;
-#else
-typedef uint8_t tx_buffer_index_t;
+#if !defined(SERIAL1_TX_BUFFER_SIZE)
+#define SERIAL1_TX_BUFFER_SIZE SERIAL_TX_BUFFER_SIZE
 #endif
-#if  (SERIAL_RX_BUFFER_SIZE>256)
-typedef uint16_t rx_buffer_index_t;
-#else
-typedef uint8_t rx_buffer_index_t;
+#if !defined(SERIAL1_RX_BUFFER_SIZE)
+#define SERIAL1_RX_BUFFER_SIZE SERIAL_RX_BUFFER_SIZE
 #endif
 
+typedef uint8_t tx_buffer_index_t;
+typedef uint8_t rx_buffer_index_t;
+
 // Define config for Serial.begin(baud, config);
 #define SERIAL_5N1 0x00
 #define SERIAL_6N1 0x02
@@ -107,17 +105,23 @@ class HardwareSerial : public Stream
     volatile tx_buffer_index_t _tx_buffer_head;
     volatile tx_buffer_index_t _tx_buffer_tail;
 
-    // Don't put any members after these buffers, since only the first
-    // 32 bytes of this struct can be accessed quickly using the ldd
-    // instruction.
-    unsigned char _rx_buffer[SERIAL_RX_BUFFER_SIZE];
-    unsigned char _tx_buffer[SERIAL_TX_BUFFER_SIZE];
+    // The buffers themselves are declared with each instance (in
+    // HardwareSerialN.cpp) so that each port can have its own sizes.
+    // _tx_buffer is NULL when the port is unbuffered.
+    unsigned char * const _rx_buffer;
+    unsigned char * const _tx_buffer;
+    const rx_buffer_index_t _rx_buffer_mask;
+    const tx_buffer_index_t _tx_buffer_mask;
+
+    inline void _write_udr(uint8_t c);
 
   public:
     inline HardwareSerial(
       volatile uint8_t *ubrrh, volatile uint8_t *ubrrl,
       volatile uint8_t *ucsra, volatile uint8_t *ucsrb,
-      volatile uint8_t *ucsrc, volatile uint8_t *udr);
+      volatile uint8_t *ucsrc, volatile uint8_t *udr,
+      unsigned char *rx_buffer, uint16_t rx_size,
+      unsigned char *tx_buffer, uint16_t tx_size);
     void begin(unsigned long baud) { begin(baud, SERIAL_8N1); }
     void begin(unsigned long, uint8_t);
     void end();
@@ -127,6 +131,7 @@ class HardwareSerial : public Stream
     virtual int availableForWrite(void);
     virtual void flush(void);
     virtual size_t write(uint8_t);
+    virtual size_t write(const uint8_t *buffer, size_t size);
     inline size_t write(unsigned long n) { return write((uint8_t)n); }
     inline size_t write(long n) { return write((uint8_t)n); }
     inline size_t write(unsigned int n) { return write((uint8_t)n); }
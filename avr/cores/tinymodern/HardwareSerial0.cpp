@@ -64,10 +64,24 @@ ISR(USART_UDRE_vect)
   Serial._tx_udr_empty_irq();
 }
 
+// The buffers, see HardwareSerial.h
+static_assert(SERIAL_RX_BUFFER_SIZE_OK(SERIAL_RX_BUFFER_SIZE), "SERIAL_RX_BUFFER_SIZE must be a power of two from 2 to 256");
+static_assert(SERIAL_TX_BUFFER_SIZE_OK(SERIAL_TX_BUFFER_SIZE), "SERIAL_TX_BUFFER_SIZE must be 0 or a power of two from 2 to 256");
+
+static unsigned char serial_rx_buffer[SERIAL_RX_BUFFER_SIZE];
+#if SERIAL_TX_BUFFER_SIZE
+static unsigned char serial_tx_buffer[SERIAL_TX_BUFFER_SIZE];
+  #define SERIAL_TX_BUFFER serial_tx_buffer
+#else
+  #define SERIAL_TX_BUFFER NULL
+#endif
+
 #if defined(UBRRH) && defined(UBRRL)
-  HardwareSerial Serial(&UBRRH, &UBRRL, &UCSRA, &UCSRB, &UCSRC, &UDR);
+  HardwareSerial Serial(&UBRRH, &UBRRL, &UCSRA, &UCSRB, &UCSRC, &UDR,
+      serial_rx_buffer, SERIAL_RX_BUFFER_SIZE, SERIAL_TX_BUFFER, SERIAL_TX_BUFFER_SIZE);
 #else
-  HardwareSerial Serial(&UBRR0H, &UBRR0L, &UCSR0A, &UCSR0B, &UCSR0C, &UDR0);
+  HardwareSerial Serial(&UBRR0H, &UBRR0L, &UCSR0A, &UCSR0B, &UCSR0C, &UDR0,
+      serial_rx_buffer, SERIAL_RX_BUFFER_SIZE, SERIAL_TX_BUFFER, SERIAL_TX_BUFFER_SIZE);
 #endif
 
 // Function that can be weakly referenced by serialEventRun to prevent
@@ -58,7 +58,20 @@ ISR(USART1_UDRE_vect)
   Serial1._tx_udr_empty_irq();
 }
 
-HardwareSerial Serial1(&UBRR1H, &UBRR1L, &UCSR1A, &UCSR1B, &UCSR1C, &UDR1);
+// The buffers, see HardwareSerial.h
+static_assert(SERIAL_RX_BUFFER_SIZE_OK(SERIAL1_RX_BUFFER_SIZE), "SERIAL1_RX_BUFFER_SIZE must be a power of two from 2 to 256");
+static_assert(SERIAL_TX_BUFFER_SIZE_OK(SERIAL1_TX_BUFFER_SIZE), "SERIAL1_TX_BUFFER_SIZE must be 0 or a power of two from 2 to 256");
+
+static unsigned char serial1_rx_buffer[SERIAL1_RX_BUFFER_SIZE];
+#if SERIAL1_TX_BUFFER_SIZE
+static unsigned char serial1_tx_buffer[SERIAL1_TX_BUFFER_SIZE];
+  #define SERIAL1_TX_BUFFER serial1_tx_buffer
+#else
+  #define SERIAL1_TX_BUFFER NULL
+#endif
+
+HardwareSerial Serial1(&UBRR1H, &UBRR1L, &UCSR1A, &UCSR1B, &UCSR1C, &UDR1,
+    serial1_rx_buffer, SERIAL1_RX_BUFFER_SIZE, SERIAL1_TX_BUFFER, SERIAL1_TX_BUFFER_SIZE);
 
 // Function that can be weakly referenced by serialEventRun to prevent
 // pulling in this file if it's not otherwise used.
@@ -46,7 +46,26 @@ ISR(USART2_UDRE_vect)
   Serial2._tx_udr_empty_irq();
 }
 
-HardwareSerial Serial2(&UBRR2H, &UBRR2L, &UCSR2A, &UCSR2B, &UCSR2C, &UDR2);
+// The buffers, see HardwareSerial.h
+#if !defined(SERIAL2_RX_BUFFER_SIZE)
+  #define SERIAL2_RX_BUFFER_SIZE SERIAL_RX_BUFFER_SIZE
+#endif
+#if !defined(SERIAL2_TX_BUFFER_SIZE)
+  #define SERIAL2_TX_BUFFER_SIZE SERIAL_TX_BUFFER_SIZE
+#endif
+static_assert(SERIAL_RX_BUFFER_SIZE_OK(SERIAL2_RX_BUFFER_SIZE), "SERIAL2_RX_BUFFER_SIZE must be a power of two from 2 to 256");
+static_assert(SERIAL_TX_BUFFER_SIZE_OK(SERIAL2_TX_BUFFER_SIZE), "SERIAL2_TX_BUFFER_SIZE must be 0 or a power of two from 2 to 256");
+
+static unsigned char serial2_rx_buffer[SERIAL2_RX_BUFFER_SIZE];
+#if SERIAL2_TX_BUFFER_SIZE
+static unsigned char serial2_tx_buffer[SERIAL2_TX_BUFFER_SIZE];
+  #define SERIAL2_TX_BUFFER serial2_tx_buffer
+#else
+  #define SERIAL2_TX_BUFFER NULL
+#endif
+
+HardwareSerial Serial2(&UBRR2H, &UBRR2L, &UCSR2A, &UCSR2B, &UCSR2C, &UDR2,
+    serial2_rx_buffer, SERIAL2_RX_BUFFER_SIZE, SERIAL2_TX_BUFFER, SERIAL2_TX_BUFFER_SIZE);
 
 // Function that can be weakly referenced by serialEventRun to prevent
 // pulling in this file if it's not otherwise used.
@@ -46,7 +46,26 @@ ISR(USART3_UDRE_vect)
   Serial3._tx_udr_empty_irq();
 }
 
-HardwareSerial Serial3(&UBRR3H, &UBRR3L, &UCSR3A, &UCSR3B, &UCSR3C, &UDR3);
+// The buffers, see HardwareSerial.h
+#if !defined(SERIAL3_RX_BUFFER_SIZE)
+  #define SERIAL3_RX_BUFFER_SIZE SERIAL_RX_BUFFER_SIZE
+#endif
+#if !defined(SERIAL3_TX_BUFFER_SIZE)
+  #define SERIAL3_TX_BUFFER_SIZE SERIAL_TX_BUFFER_SIZE
+#endif
+static_assert(SERIAL_RX_BUFFER_SIZE_OK(SERIAL3_RX_BUFFER_SIZE), "SERIAL3_RX_BUFFER_SIZE must be a power of two from 2 to 256");
+static_assert(SERIAL_TX_BUFFER_SIZE_OK(SERIAL3_TX_BUFFER_SIZE), "SERIAL3_TX_BUFFER_SIZE must be 0 or a power of two from 2 to 256");
+
+static unsigned char serial3_rx_buffer[SERIAL3_RX_BUFFER_SIZE];
+#if SERIAL3_TX_BUFFER_SIZE
+static unsigned char serial3_tx_buffer[SERIAL3_TX_BUFFER_SIZE];
+  #define SERIAL3_TX_BUFFER serial3_tx_buffer
+#else
+  #define SERIAL3_TX_BUFFER NULL
+#endif
+
+HardwareSerial Serial3(&UBRR3H, &UBRR3L, &UCSR3A, &UCSR3B, &UCSR3C, &UDR3,
+    serial3_rx_buffer, SERIAL3_RX_BUFFER_SIZE, SERIAL3_TX_BUFFER, SERIAL3_TX_BUFFER_SIZE);
 
 // Function that can be weakly referenced by serialEventRun to prevent
 // pulling in this file if it's not otherwise used.
@@ -82,17 +82,25 @@
 #error "Not all bit positions for UART3 are the same as for UART0"
 #endif
 
+// Buffer sizes for HardwareSerialN.cpp to check, see HardwareSerial.h
+#define SERIAL_RX_BUFFER_SIZE_OK(n) ((n) >= 2 && (n) <= 256 && ((n) & ((n) - 1)) == 0)
+#define SERIAL_TX_BUFFER_SIZE_OK(n) ((n) == 0 || SERIAL_RX_BUFFER_SIZE_OK(n))
+
 // Constructors ////////////////////////////////////////////////////////////////
 
 HardwareSerial::HardwareSerial(
   volatile uint8_t *ubrrh, volatile uint8_t *ubrrl,
   volatile uint8_t *ucsra, volatile uint8_t *ucsrb,
-  volatile uint8_t *ucsrc, volatile uint8_t *udr) :
+  volatile uint8_t *ucsrc, volatile uint8_t *udr,
+  unsigned char *rx_buffer, uint16_t rx_size,
+  unsigned char *tx_buffer, uint16_t tx_size) :
     _ubrrh(ubrrh), _ubrrl(ubrrl),
     _ucsra(ucsra), _ucsrb(ucsrb), _ucsrc(ucsrc),
     _udr(udr),
     _rx_buffer_head(0), _rx_buffer_tail(0),
-    _tx_buffer_head(0), _tx_buffer_tail(0)
+    _tx_buffer_head(0), _tx_buffer_tail(0),
+    _rx_buffer(rx_buffer), _tx_buffer(tx_buffer),
+    _rx_buffer_mask(rx_size - 1), _tx_buffer_mask(tx_size - 1)
 {
 }
 
@@ -104,7 +112,7 @@ void HardwareSerial::_rx_complete_irq(void)
     // No Parity error, read byte and store it in the buffer if there is
     // room
     unsigned char c = *_udr;
-    rx_buffer_index_t i = (unsigned int)(_rx_buffer_head + 1) % SERIAL_RX_BUFFER_SIZE;
+    rx_buffer_index_t i = (rx_buffer_index_t)(_rx_buffer_head + 1) & _rx_buffer_mask;
 
     // if we should be storing the received character into the location
     // just before the tail (meaning that the head would advance to the
@@ -33,6 +33,10 @@ unsigned long pulseIn(uint8_t pin, uint8_t state, unsigned long timeout = 100000
 #ifndef DISABLEMILLIS
 unsigned long pulseInLong(uint8_t pin, uint8_t state, unsigned long timeout = 1000000L);
 #endif
+#if defined(ICR1)
+unsigned long pulseInCapture(uint8_t state, unsigned long timeout = 1000000L);
+void pulseInNonBlocking(uint8_t state, uint16_t *train = NULL, uint8_t count = 1);
+#endif
 
 void tone(uint8_t _pin, unsigned long frequency, unsigned long duration = 0);
 void noTone(uint8_t _pin = 255);
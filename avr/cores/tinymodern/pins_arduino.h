@@ -110,6 +110,8 @@ extern const uint8_t PROGMEM port_to_pullup_PGM[];
 
 #define analogInputToDigitalPin(p)  ((p < 9) ? 10 -(p): (p==9)?11:(11-(p)))
 
+#define digitalPinToBitMaskConst(P) ((P)<3?_BV(P):((P)==11?_BV(3):_BV(10-(P))))
+
 #define digitalPinToPCICR(p)    (((p) >= 0 && (p) <= 10) ? (&GIMSK) : ((uint8_t *)NULL))
 #define digitalPinToPCICRbit(p) (((p) <= 2) ? PCIE1 : PCIE0)
 #define digitalPinToPCMSK(p)    (((p) <= 2) ? (&PCMSK1) : (((p) <= 10) ? (&PCMSK0) : ((uint8_t *)NULL)))
@@ -137,12 +139,21 @@ extern const uint8_t PROGMEM port_to_pullup_PGM[];
 
 #define analogInputToDigitalPin(p)  (p<9?p:(p==11?9:p-1))
 
+#define digitalPinToBitMaskConst(P) ((P)<8?_BV(P):((P)==8?_BV(2):((P)==9?_BV(1):((P)==10?_BV(0):_BV(3)))))
+
 #define digitalPinToPCICR(p)    (((p) >= 0 && (p) <= 10) ? (&GIMSK) : ((uint8_t *)NULL))
 #define digitalPinToPCICRbit(p) (((p) > 7) ? PCIE1 : PCIE0)
 #define digitalPinToPCMSK(p)    (((p)  < 8) ? (&PCMSK0) : (((p) <= 11) ? (&PCMSK0) : ((uint8_t *)NULL)))
 #define digitalPinToPCMSKbit(p) (((p) <8 ) ? (p) : ((p==8?2:(p==11?3:(p==9?1:0)))))
 #endif
 
+// The port lookups are already plain expressions on this part
+#define digitalPinToPortConst(P)    digitalPinToPort(P)
+#define portOutputRegisterConst(P)  portOutputRegister(P)
+#define portInputRegisterConst(P)   portInputRegister(P)
+#define portModeRegisterConst(P)    portModeRegister(P)
+#define portPullupRegisterConst(P)  portPullupRegister(P)
+
 #endif
 
 #if defined(__AVR_ATtiny1634__)
@@ -200,6 +211,12 @@ extern const uint8_t PROGMEM port_to_pullup_PGM[];
 
 #define analogInputToDigitalPin(p)  ((p < 6) ? 5 -(p):(22-(p)))
 
+// Same split as digitalPinToPCX() above, 17 is RESET (C3)
+#define digitalPinToPortConst(P)    ((P)<1?PORT_B_ID:((P)<=8?PORT_A_ID:((P)<=13?PORT_C_ID:((P)<=16?PORT_B_ID:PORT_C_ID))))
+#define digitalPinToBitMaskConst(P) ((P)<1?_BV(0):((P)<=8?_BV(8-(P)):((P)<=10?_BV(14-(P)):((P)<=13?_BV(13-(P)):((P)<=16?_BV(17-(P)):_BV(3))))))
+
+#define portRegisterConst_(P,REG)   ((P)==PORT_A_ID?&REG##A:((P)==PORT_B_ID?&REG##B:&REG##C))
+
 #endif
 
 #if defined(__AVR_ATtiny828__)
@@ -222,8 +239,25 @@ extern const uint8_t PROGMEM port_to_pullup_PGM[];
 #define digitalPinToPCMSK(p)    (p<8?&PCMSK0:(p<16?&PCMSK1:(p<24?&PCMSK2:&PCMSK3)))
 #define digitalPinToPCMSKbit(p) (1<<(p&7))
 
+#define digitalPinToPortConst(P)    (((P)>>3)+1)
+#define digitalPinToBitMaskConst(P) _BV((P)&7)
 
+#define portRegisterConst_(P,REG)   ((P)==PORT_A_ID?&REG##A:((P)==PORT_B_ID?&REG##B:((P)==PORT_C_ID?&REG##C:&REG##D)))
 
 #endif
 
+/*
+  Compile time pin lookups.  These give the same answers as the table driven
+  macros above, but as plain expressions, so that when the pin is a compile
+  time constant the whole lookup folds away and the constant pin versions of
+  pinMode/digitalWrite/digitalRead in wiring.h come down to an sbi/cbi/sbic.
+  Do not use them with a pin which is not constant, they are big.
+*/
+#if defined(portRegisterConst_)
+#define portOutputRegisterConst(P)  portRegisterConst_(P,PORT)
+#define portInputRegisterConst(P)   portRegisterConst_(P,PIN)
+#define portModeRegisterConst(P)    portRegisterConst_(P,DDR)
+#define portPullupRegisterConst(P)  portRegisterConst_(P,PUE)
+#endif
+
 #endif //end of include guard
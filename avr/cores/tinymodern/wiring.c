@@ -67,27 +67,86 @@
 // the overflow handler is called every 256 ticks.
 #define MICROSECONDS_PER_MILLIS_OVERFLOW (clockCyclesToMicroseconds(MillisTimer_Prescale_Value * 256))
 
-// the whole number of milliseconds per millis timer overflow
-#define MILLIS_INC (MICROSECONDS_PER_MILLIS_OVERFLOW / 1000)
+// How far millis() and micros() may drift from the system clock, in parts per million. Set by the Tools -> Millis
+// Accuracy menu (or -DACCEPTABLE_MILLIS_ERROR_PPM=); a larger value allows the smaller approximations below.
+#ifndef ACCEPTABLE_MILLIS_ERROR_PPM
+  #ifdef ACCEPTABLE_MICROS_ERROR_PPM
+    #define ACCEPTABLE_MILLIS_ERROR_PPM ACCEPTABLE_MICROS_ERROR_PPM
+  #else
+    #define ACCEPTABLE_MILLIS_ERROR_PPM 500
+  #endif
+#endif
+
+#ifndef ACCEPTABLE_MICROS_ERROR_PPM
+  #define ACCEPTABLE_MICROS_ERROR_PPM ACCEPTABLE_MILLIS_ERROR_PPM
+#endif
 
-// the fractional number of milliseconds per millis timer overflow. we shift right
-// by three to fit these numbers into a byte. (for the clock speeds we care
-// about - 8 and 16 MHz - this doesn't lose precision.)
-#define FRACT_INC ((MICROSECONDS_PER_MILLIS_OVERFLOW % 1000) >> 3)
-#define FRACT_MAX (1000 >> 3)
+// The classic fractional accumulator: the whole number of milliseconds per millis timer overflow, and the
+// fractional part in units of 8 microseconds so it fits in a byte. For 8 and 16 MHz this doesn't lose precision, but
+// at other clocks the microseconds per overflow is truncated and then rounded down to 8, which can be off by 0.6%.
+#define MILLIS_INC_8 (MICROSECONDS_PER_MILLIS_OVERFLOW / 1000)
+#define FRACT_INC_8 ((MICROSECONDS_PER_MILLIS_OVERFLOW % 1000) >> 3)
+#define FRACT_MAX_8 (1000 >> 3)
+
+// The error of the above in ppm: what it adds up to per overflow, against the MillisTimer_Prescale_Value * 256 clock
+// cycles that really went by.
+#define MILLIS_ERROR_8_A ((MILLIS_INC_8 * 1000 + (FRACT_INC_8 << 3)) * F_CPU)
+#define MILLIS_ERROR_8_B (MillisTimer_Prescale_Value * 256 * 1000000)
+#define MILLIS_ERROR_8_PPM (((MILLIS_ERROR_8_A > MILLIS_ERROR_8_B) ? (MILLIS_ERROR_8_A - MILLIS_ERROR_8_B) : \
+                             (MILLIS_ERROR_8_B - MILLIS_ERROR_8_A)) / (MillisTimer_Prescale_Value * 256))
+
+#if MILLIS_ERROR_8_PPM <= ACCEPTABLE_MILLIS_ERROR_PPM
+  #define MILLIS_INC MILLIS_INC_8
+  #define FRACT_INC FRACT_INC_8
+  #define FRACT_MAX FRACT_MAX_8
+  typedef unsigned char millis_fract_t;
+#else
+  // Otherwise count the fraction in clock cycles instead: a millisecond is F_CPU / 1000 of them, and an overflow is
+  // MillisTimer_Prescale_Value * 256. Times 1000, that is F_CPU and a power of two times 1000, which are shifted
+  // right together until F_CPU fits in 15 bits so the accumulator stays 16 bits wide. Only the bits shifted off of
+  // F_CPU are lost, which is under 31 ppm (and nothing when F_CPU is a multiple of 1 << MILLIS_FRACT_SHIFT).
+  #if   F_CPU < (0x8000L << 0)
+    #define MILLIS_FRACT_SHIFT 0
+  #elif F_CPU < (0x8000L << 1)
+    #define MILLIS_FRACT_SHIFT 1
+  #elif F_CPU < (0x8000L << 2)
+    #define MILLIS_FRACT_SHIFT 2
+  #elif F_CPU < (0x8000L << 3)
+    #define MILLIS_FRACT_SHIFT 3
+  #elif F_CPU < (0x8000L << 4)
+    #define MILLIS_FRACT_SHIFT 4
+  #elif F_CPU < (0x8000L << 5)
+    #define MILLIS_FRACT_SHIFT 5
+  #elif F_CPU < (0x8000L << 6)
+    #define MILLIS_FRACT_SHIFT 6
+  #elif F_CPU < (0x8000L << 7)
+    #define MILLIS_FRACT_SHIFT 7
+  #elif F_CPU < (0x8000L << 8)
+    #define MILLIS_FRACT_SHIFT 8
+  #elif F_CPU < (0x8000L << 9)
+    #define MILLIS_FRACT_SHIFT 9
+  #else
+    #define MILLIS_FRACT_SHIFT 10
+  #endif
+  #define MILLIS_FRACT_CYCLES (((unsigned long)MillisTimer_Prescale_Value * 256 * 1000) >> MILLIS_FRACT_SHIFT)
+  #define FRACT_MAX ((unsigned int)((F_CPU + ((1L << MILLIS_FRACT_SHIFT) >> 1)) >> MILLIS_FRACT_SHIFT))
+  #define MILLIS_INC (MILLIS_FRACT_CYCLES / FRACT_MAX)
+  #define FRACT_INC ((unsigned int)(MILLIS_FRACT_CYCLES % FRACT_MAX))
+  typedef unsigned int millis_fract_t;
+#endif
 
 #ifndef DISABLEMILLIS
 
 volatile unsigned long millis_timer_overflow_count = 0;
 volatile unsigned long millis_timer_millis = 0;
-static unsigned char millis_timer_fract = 0;
+static millis_fract_t millis_timer_fract = 0;
 
 ISR(MILLISTIMER_OVF_vect)
 {
   // copy these to local variables so they can be stored in registers
   // (volatile variables must be read from memory on every access)
   unsigned long m = millis_timer_millis;
-  unsigned char f = millis_timer_fract;
+  millis_fract_t f = millis_timer_fract;
 
 /* rmv: The code below generates considerably less code (empty Sketch is 326 versus 304)...
 
@@ -168,40 +227,105 @@ unsigned long micros()
   return ((m << 8) + t) * MillisTimer_Prescale_Value * (1000000L/F_CPU);
 #else
 #if (MillisTimer_Prescale_Value % clockCyclesPerMicrosecond() == 0 ) // Can we just do it the naive way? If so great!
-  return ((m << 8) + t) * (MillisTimer_Prescale_Value / clockCyclesPerMicrosecond());
-  // Otherwise we do clock-specific calculations
+  // The prescaler is a power of two, so this is too: spell it out as a shift so it never becomes a 32-bit multiply.
+  #if   (MillisTimer_Prescale_Value / clockCyclesPerMicrosecond() == 1)
+    #define MICROS_SHIFT 0
+  #elif (MillisTimer_Prescale_Value / clockCyclesPerMicrosecond() == 2)
+    #define MICROS_SHIFT 1
+  #elif (MillisTimer_Prescale_Value / clockCyclesPerMicrosecond() == 4)
+    #define MICROS_SHIFT 2
+  #elif (MillisTimer_Prescale_Value / clockCyclesPerMicrosecond() == 8)
+    #define MICROS_SHIFT 3
+  #elif (MillisTimer_Prescale_Value / clockCyclesPerMicrosecond() == 16)
+    #define MICROS_SHIFT 4
+  #elif (MillisTimer_Prescale_Value / clockCyclesPerMicrosecond() == 32)
+    #define MICROS_SHIFT 5
+  #else
+    #define MICROS_SHIFT 6
+  #endif
+  return ((m << 8) + t) << MICROS_SHIFT;
+  // Otherwise we do clock-specific calculations, with a closer (longer) sum of shifts where the short one is further
+  // off than ACCEPTABLE_MICROS_ERROR_PPM.
 #elif (MillisTimer_Prescale_Value == 64 && F_CPU == 12800000L)  //64/12.8=5, but the compiler wouldn't realize it because of integer math - this is a supported speed for Micronucleus.
-  return ((m << 8) + t) * 5;
-  // Otherwise we do clock-specific calculations
+  m = (m << 8) + t;
+  return (m << 2) + m;
 #elif (MillisTimer_Prescale_Value == 64 && F_CPU == 24000000L) // 2.6875 vs real value 2.67
   m = (m << 8) + t;
+  #if ACCEPTABLE_MICROS_ERROR_PPM >= 7813
   return (m<<1) + (m >> 1) + (m >> 3) + (m >> 4); // multiply by 2.6875
+  #else
+  return (m<<1) + (m >> 1) + (m >> 3) + (m >> 5) + (m >> 7) + (m >> 9); // 2.66602, 244 ppm
+  #endif
 #elif (MillisTimer_Prescale_Value == 64 && clockCyclesPerMicrosecond() == 20) // 3.187 vs real value 3.2
   m=(m << 8) + t;
+  #if ACCEPTABLE_MICROS_ERROR_PPM >= 3907
   return m+(m<<1)+(m>>2)-(m>>4);
+  #else
+  return m+(m<<1)+(m>>3)+(m>>4)+(m>>7)+(m>>8); // 3.19922, 244 ppm
+  #endif
 #elif (MillisTimer_Prescale_Value == 64 && F_CPU == 18432000L) // 3.5 vs real value 3.47
   m=(m << 8) + t;
+  #if ACCEPTABLE_MICROS_ERROR_PPM >= 8000
   return m+(m<<1)+(m>>1);
+  #else
+  return m+(m<<1)+(m>>1)-(m>>5)+(m>>8); // 3.47266, 125 ppm
+  #endif
 #elif (MillisTimer_Prescale_Value == 64 && F_CPU == 14745600L) //4.375  vs real value 4.34
   m=(m << 8) + t;
+  #if ACCEPTABLE_MICROS_ERROR_PPM >= 8000
   return (m<<2)+(m>>1)-(m>>3);
+  #else
+  return (m<<2)+(m>>2)+(m>>4)+(m>>5)-(m>>8); // 4.33984, 100 ppm
+  #endif
 #elif (MillisTimer_Prescale_Value == 64 && clockCyclesPerMicrosecond() == 14) //4.5 - actual 4.57 for 14.0mhz, 4.47 for the 14.3 crystals scrappable from everything
   m=(m << 8) + t;
+  #if F_CPU == 14000000L && ACCEPTABLE_MICROS_ERROR_PPM < 15625
+  return (m<<2)+(m>>1)+(m>>4)+(m>>7); // 4.57031, 244 ppm
+  #else
   return (m<<2)+(m>>1);
+  #endif
 #elif (MillisTimer_Prescale_Value == 64 && clockCyclesPerMicrosecond() == 12) // 5.3125 vs real value 5.333
   m=(m << 8) + t;
+  #if ACCEPTABLE_MICROS_ERROR_PPM >= 3907
   return m+(m<<2)+(m>>2)+(m>>4);
+  #else
+  return m+(m<<2)+(m>>2)+(m>>4)+(m>>6)+(m>>8); // 5.33203, 244 ppm
+  #endif
 #elif (MillisTimer_Prescale_Value == 64 && clockCyclesPerMicrosecond() == 11) // 5.75 vs real value 5.818 (11mhz) 5.78 (11.059)
   m=(m << 8) + t;
+  #if F_CPU == 11059200L && ACCEPTABLE_MICROS_ERROR_PPM < 6400
+  return m+(m<<2)+(m>>1)+(m>>2)+(m>>5)+(m>>8)+(m>>9); // 5.78711, 13 ppm
+  #else
   return m+(m<<2)+(m>>1)+(m>>2);
+  #endif
 #elif (MillisTimer_Prescale_Value == 64 && F_CPU==7372800L) // 8.625, vs real value 8.68
   m=(m << 8) + t;
-  return (m<<3)+(m>>2)+(m>>3);
+  #if ACCEPTABLE_MICROS_ERROR_PPM >= 6400
+  return (m<<3)+(m>>1)+(m>>3);
+  #else
+  return (m<<3)+(m>>1)+(m>>3)+(m>>4)-(m>>7); // 8.67969, 100 ppm
+  #endif
 #elif (MillisTimer_Prescale_Value == 64 && F_CPU==6000000L) // 10.625, vs real value 10.67
   m=(m << 8) + t;
-  return (m<<3)+(m<<1)+(m>>2)+(m>>3);
-#elif (MillisTimer_Prescale_Value == 64 && clockCyclesPerMicrosecond() == 9) // For 9mhz, this is a little off, but for 9.21, it's very close!
-  return ((m << 8) + t) * (MillisTimer_Prescale_Value / clockCyclesPerMicrosecond());
+  #if ACCEPTABLE_MICROS_ERROR_PPM >= 3907
+  return (m<<3)+(m<<1)+(m>>1)+(m>>3);
+  #else
+  return (m<<3)+(m<<1)+(m>>1)+(m>>3)+(m>>5)+(m>>7); // 10.66406, 244 ppm
+  #endif
+#elif (MillisTimer_Prescale_Value == 64 && F_CPU == 9216000L) // 6.9375 vs real value 6.944
+  m=(m << 8) + t;
+  #if ACCEPTABLE_MICROS_ERROR_PPM >= 1000
+  return (m<<3)-m-(m>>4);
+  #else
+  return (m<<3)-m-(m>>4)+(m>>7)-(m>>10); // 6.94434, 16 ppm
+  #endif
+#elif (MillisTimer_Prescale_Value == 64 && clockCyclesPerMicrosecond() == 9) // 7.125 vs real value 7.111 for 9.0mhz
+  m=(m << 8) + t;
+  #if ACCEPTABLE_MICROS_ERROR_PPM >= 1953
+  return (m<<3)-m+(m>>3);
+  #else
+  return (m<<3)-m+(m>>4)+(m>>5)+(m>>6)+(m>>9); // 7.11133, 31 ppm
+  #endif
 #else
   //return ((m << 8) + t) * (MillisTimer_Prescale_Value / clockCyclesPerMicrosecond());
   //return ((m << 8) + t) * MillisTimer_Prescale_Value / clockCyclesPerMicrosecond();
@@ -33,6 +33,9 @@
 
 #include "binary.h"
 #include "core_build_options.h"
+#include "core_pins.h"
+#include "pins_arduino.h"
+#include "PwmTimer.h"
 
 #ifdef __cplusplus
 extern "C"{
@@ -179,9 +182,9 @@ typedef uint8_t byte;
 void initToneTimer(void);
 void init(void);
 
-void pinMode(uint8_t, uint8_t);
-void digitalWrite(uint8_t, uint8_t);
-int digitalRead(uint8_t);
+void _pinMode(uint8_t, uint8_t);
+void _digitalWrite(uint8_t, uint8_t);
+int _digitalRead(uint8_t);
 int analogRead(int8_t);
 void analogReference(uint8_t mode);
 void analogWrite(uint8_t, int);
@@ -206,6 +209,15 @@ unsigned long micros(void);
 void delay(unsigned long);
 void delayMicroseconds(unsigned int us);
 unsigned long pulseIn(uint8_t pin, uint8_t state, unsigned long timeout);
+#if defined(ICR1)
+// Pulse measurement on the ICP1 pin with the Timer1 input capture unit, see
+// wiring_pulse_capture.c.  Timer1 can't be used for anything else meanwhile.
+unsigned long pulseInCapture(uint8_t state, unsigned long timeout);
+void pulseInNonBlocking(uint8_t state, uint16_t *train, uint8_t count);
+uint8_t pulseInAvailable(void);
+unsigned long pulseInResult(void);
+void pulseInStop(void);
+#endif
 
 void shiftOut(uint8_t dataPin, uint8_t clockPin, uint8_t bitOrder, uint8_t val);
 uint8_t shiftIn(uint8_t dataPin, uint8_t clockPin, uint8_t bitOrder);
@@ -216,6 +228,198 @@ void detachInterrupt(uint8_t);
 void setup(void);
 void loop(void);
 
+/*=============================================================================
+  Constant pin fast paths.
+
+  When pinMode(), digitalWrite() or digitalRead() are called with a pin that
+  is a compile time constant (the usual case), everything the out of line
+  versions in wiring_digital.c look up at run time is known at compile time,
+  so these inlines do the work directly and it optimises down to an sbi/cbi
+  (or sbic/sbis) per register touched.  Non constant pins fall through to the
+  out of line _pinMode(), _digitalWrite() and _digitalRead().
+
+  The behaviour is the same as the out of line versions, analog pin numbers
+  (A0...) are accepted on the x41 and 1634, PWM is turned off by
+  digitalWrite(), and the pullup (PUEx) is cleared by digitalWrite() and
+  OUTPUT.
+=============================================================================*/
+
+// Set or clear bits in a register whose address is constant.  In the low I/O
+// space that is a single (atomic) sbi/cbi, anywhere else we have to protect
+// the read-modify-write ourselves.
+__attribute__((always_inline)) static inline void _setBitsConst( volatile uint8_t *reg, uint8_t mask )
+{
+  if ( (uint16_t)reg < 0x40 )
+  {
+    *reg |= mask;
+  }
+  else
+  {
+    uint8_t oldSREG = SREG;
+    cli();
+    *reg |= mask;
+    SREG = oldSREG;
+  }
+}
+
+__attribute__((always_inline)) static inline void _clearBitsConst( volatile uint8_t *reg, uint8_t mask )
+{
+  if ( (uint16_t)reg < 0x40 )
+  {
+    *reg &= ~mask;
+  }
+  else
+  {
+    uint8_t oldSREG = SREG;
+    cli();
+    *reg &= ~mask;
+    SREG = oldSREG;
+  }
+}
+
+// Disconnect the timer from a pin, for a constant pin this is a single
+// TCCRnA update (or nothing at all if the pin has no PWM).  On the x41 the
+// CORE_PWMn_PIN definitions already account for the TOCC remapping done in
+// init(), so the pin to timer channel relationship is fixed.
+__attribute__((always_inline)) static inline void turnOffPWM( uint8_t pin )
+{
+  #if CORE_PWM_COUNT >= 1
+    if ( pin == CORE_PWM0_PIN )
+    {
+      Pwm0_SetCompareOutputMode( Pwm0_Disconnected );
+    }
+    else
+  #endif
+
+  #if CORE_PWM_COUNT >= 2
+    if ( pin == CORE_PWM1_PIN )
+    {
+      Pwm1_SetCompareOutputMode( Pwm1_Disconnected );
+    }
+    else
+  #endif
+
+  #if CORE_PWM_COUNT >= 3
+    if ( pin == CORE_PWM2_PIN )
+    {
+      Pwm2_SetCompareOutputMode( Pwm2_Disconnected );
+    }
+    else
+  #endif
+
+  #if CORE_PWM_COUNT >= 4
+    if ( pin == CORE_PWM3_PIN )
+    {
+      Pwm3_SetCompareOutputMode( Pwm3_Disconnected );
+    }
+    else
+  #endif
+
+  #if CORE_PWM_COUNT >= 5
+    if ( pin == CORE_PWM4_PIN )
+    {
+      Pwm4_SetCompareOutputMode( Pwm4_Disconnected );
+    }
+    else
+  #endif
+
+  #if CORE_PWM_COUNT >= 6
+
+    if ( pin == CORE_PWM5_PIN )
+    {
+      Pwm5_SetCompareOutputMode( Pwm5_Disconnected );
+    }
+    //else
+  #endif
+
+  #if CORE_PWM_COUNT >= 7
+  #error Only 6 PWM pins are supported.  Add more conditions.
+  #endif
+{
+    }
+}
+
+// A0... are the ADC channel + 64, except on the 828 where they are the
+// digital pin numbers already.
+#ifndef __AVR_ATtiny828__
+  #define constDigitalPin_(P) (((P) & 64) ? analogInputToDigitalPin(((P) & 63)) : (P))
+#else
+  #define constDigitalPin_(P) (P)
+#endif
+
+__attribute__((always_inline, unused)) static inline void pinMode( uint8_t pin, uint8_t mode )
+{
+  if ( __builtin_constant_p(pin) )
+  {
+    pin = constDigitalPin_(pin);
+    if ( pin >= NUM_DIGITAL_PINS ) return;
+
+    uint8_t port = digitalPinToPortConst(pin);
+    uint8_t bit  = digitalPinToBitMaskConst(pin);
+
+    if ( mode == INPUT )
+    {
+      _clearBitsConst( portModeRegisterConst(port),   bit );
+      _clearBitsConst( portOutputRegisterConst(port), bit );
+      _clearBitsConst( portPullupRegisterConst(port), bit );
+    }
+    else if ( mode == INPUT_PULLUP )
+    {
+      _clearBitsConst( portModeRegisterConst(port),   bit );
+      _setBitsConst(   portOutputRegisterConst(port), bit );
+      _setBitsConst(   portPullupRegisterConst(port), bit );
+    }
+    else
+    {
+      _clearBitsConst( portPullupRegisterConst(port), bit );
+      _setBitsConst(   portModeRegisterConst(port),   bit );
+    }
+    return;
+  }
+
+  _pinMode(pin, mode);
+}
+
+__attribute__((always_inline, unused)) static inline void digitalWrite( uint8_t pin, uint8_t val )
+{
+  if ( __builtin_constant_p(pin) )
+  {
+    pin = constDigitalPin_(pin);
+    if ( pin >= NUM_DIGITAL_PINS ) return;
+
+    uint8_t port = digitalPinToPortConst(pin);
+    uint8_t bit  = digitalPinToBitMaskConst(pin);
+
+    turnOffPWM( pin );
+
+    if ( val == LOW )
+    {
+      _clearBitsConst( portOutputRegisterConst(port), bit );
+    }
+    else
+    {
+      _setBitsConst(   portOutputRegisterConst(port), bit );
+    }
+    _clearBitsConst( portPullupRegisterConst(port), bit );
+    return;
+  }
+
+  _digitalWrite(pin, val);
+}
+
+__attribute__((always_inline, unused)) static inline int digitalRead( uint8_t pin )
+{
+  if ( __builtin_constant_p(pin) )
+  {
+    pin = constDigitalPin_(pin);
+    if ( pin >= NUM_DIGITAL_PINS ) return LOW;
+
+    return ( *portInputRegisterConst(digitalPinToPortConst(pin)) & digitalPinToBitMaskConst(pin) ) ? HIGH : LOW;
+  }
+
+  return _digitalRead(pin);
+}
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
@@ -33,7 +33,7 @@
 #include "PwmTimer.h"
 
 #if defined(__AVR_ATtinyX41__ ) || defined(__AVR_ATtiny1634__) || defined(__AVR_ATtiny828__)
-void pinMode(uint8_t pin, uint8_t mode)
+void _pinMode(uint8_t pin, uint8_t mode)
 {
   #ifndef __AVR_ATtiny828__
   if (pin&64) {pin=analogInputToDigitalPin((pin & 63));}
@@ -73,7 +73,7 @@ void pinMode(uint8_t pin, uint8_t mode)
 }
 #else
 
-void pinMode(uint8_t pin, uint8_t mode)
+void _pinMode(uint8_t pin, uint8_t mode)
 {
   #ifndef __AVR_ATtiny828__
   if (pin&64) {pin=analogInputToDigitalPin((pin&63));}
@@ -110,74 +110,12 @@ void pinMode(uint8_t pin, uint8_t mode)
 
 #endif
 
-// Forcing this inline keeps the callers from having to push their own stuff
-// on the stack. It is a good performance win and only takes 1 more byte per
-// user than calling. (It will take more bytes on the 168.)
-//
-// But shouldn't this be moved into pinMode? Seems silly to check and do on
-// each digitalread or write.
-//
-__attribute__((always_inline)) static inline void turnOffPWM( uint8_t pin )
-{
-  #if CORE_PWM_COUNT >= 1
-    if ( pin == CORE_PWM0_PIN )
-    {
-      Pwm0_SetCompareOutputMode( Pwm0_Disconnected );
-    }
-    else
-  #endif
-
-  #if CORE_PWM_COUNT >= 2
-    if ( pin == CORE_PWM1_PIN )
-    {
-      Pwm1_SetCompareOutputMode( Pwm1_Disconnected );
-    }
-    else
-  #endif
-
-  #if CORE_PWM_COUNT >= 3
-    if ( pin == CORE_PWM2_PIN )
-    {
-      Pwm2_SetCompareOutputMode( Pwm2_Disconnected );
-    }
-    else
-  #endif
-
-  #if CORE_PWM_COUNT >= 4
-    if ( pin == CORE_PWM3_PIN )
-    {
-      Pwm3_SetCompareOutputMode( Pwm3_Disconnected );
-    }
-    else
-  #endif
-
-  #if CORE_PWM_COUNT >= 5
-    if ( pin == CORE_PWM4_PIN )
-    {
-      Pwm4_SetCompareOutputMode( Pwm4_Disconnected );
-    }
-    else
-  #endif
-
-  #if CORE_PWM_COUNT >= 6
-
-    if ( pin == CORE_PWM5_PIN )
-    {
-      Pwm5_SetCompareOutputMode( Pwm5_Disconnected );
-    }
-    //else
-  #endif
-
-  #if CORE_PWM_COUNT >= 7
-  #error Only 6 PWM pins are supported.  Add more conditions.
-  #endif
-{
-    }
-}
+// turnOffPWM() lives in wiring.h so that the constant pin digitalWrite() can
+// use it as well.
 
 #if defined(__AVR_ATtinyX41__ ) || defined(__AVR_ATtiny1634__) || defined(__AVR_ATtiny828__)
 
-void digitalWrite(uint8_t pin, uint8_t val)
+void _digitalWrite(uint8_t pin, uint8_t val)
 {
   #ifndef __AVR_ATtiny828__
   if (pin&64) {pin=analogInputToDigitalPin((pin&63));}
@@ -211,7 +149,7 @@ void digitalWrite(uint8_t pin, uint8_t val)
 }
 #else
 
-void digitalWrite(uint8_t pin, uint8_t val)
+void _digitalWrite(uint8_t pin, uint8_t val)
 {
   #ifndef __AVR_ATtiny828__
   if (pin&64) {pin=analogInputToDigitalPin((pin&63));}
@@ -242,9 +180,11 @@ void digitalWrite(uint8_t pin, uint8_t val)
 }
 #endif
 
-int digitalRead(uint8_t pin)
+int _digitalRead(uint8_t pin)
 {
-  if (pin&128) {pin=analogInputToDigitalPin((pin&127));}
+  #ifndef __AVR_ATtiny828__
+  if (pin&64) {pin=analogInputToDigitalPin((pin&63));}
+  #endif
   uint8_t bit = digitalPinToBitMask(pin);
   uint8_t port = digitalPinToPort(pin);
 
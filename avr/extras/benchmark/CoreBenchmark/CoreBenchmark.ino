@@ -0,0 +1,144 @@
+/* CoreBenchmark - cycle counts of the core hot paths.
+|
+|  This sketch is not meant to be looked at on real hardware (although it will
+|  happily run there), it is driven by extras/benchmark/run_benchmarks.sh which
+|  compiles it for every board/variant and runs it under simavr through the
+|  simbench host.
+|
+|  Each benchmark writes its id (see bench_ids.h) to GPIOR0 immediately before
+|  the code under test and BENCH_MARKER_STOP immediately after it, simbench
+|  records the simulator cycle counter on each write, so the numbers reported
+|  are exact cycle counts, not timer estimates.
+|
+|  Any input which the compiler might be able to treat as a constant (when we
+|  do not want it to) is read from a volatile before the start marker and any
+\  result is written to a volatile after the stop marker. */
+
+#include "bench_ids.h"
+
+#ifndef GPIOR0
+  #error "CoreBenchmark signals the simulator through GPIOR0, which this chip does not have."
+#endif
+
+// The pin used for the digital benchmarks, it should not be one of the
+// Serial pins.  3 is a general purpose pin on every supported part, and is
+// a PWM pin on several of them so that turning off PWM is included.
+#ifndef BENCH_DIGITAL_PIN
+  #define BENCH_DIGITAL_PIN 3
+#endif
+
+// Channel 1 is a single ended input on every part with an ADC
+#ifndef BENCH_ANALOG_CHANNEL
+  #define BENCH_ANALOG_CHANNEL 1
+#endif
+
+#if defined(NO_MILLIS) || defined(DISABLEMILLIS)
+  #define BENCH_HAVE_MILLIS 0
+#else
+  #define BENCH_HAVE_MILLIS 1
+#endif
+
+#define BENCH(ID, CODE)                                   \
+  for (uint8_t r = 0; r < BENCH_REPEAT; r++) {           \
+    GPIOR0 = (ID);                                        \
+    CODE;                                                 \
+    GPIOR0 = BENCH_MARKER_STOP;                           \
+  }
+
+// printNumber() is measured into a sink that throws everything away so that
+// we are measuring the number formatting and not the serial port.
+class NullPrint : public Print
+{
+  public:
+    virtual size_t write(uint8_t) { return 1; }
+};
+
+NullPrint nullPrint;
+
+volatile uint8_t  benchPin    = BENCH_DIGITAL_PIN;
+volatile uint8_t  benchByte   = 0xA5;
+volatile uint32_t benchLong   = 4000000000UL;
+volatile uint32_t benchResult;
+
+void setup() {
+  Serial.begin(115200);
+  pinMode(BENCH_DIGITAL_PIN, OUTPUT);
+
+  BENCH(1, ;);
+
+  BENCH(2, digitalWrite(BENCH_DIGITAL_PIN, HIGH));
+
+  {
+    uint8_t p = benchPin;
+    BENCH(3, digitalWrite(p, LOW));
+  }
+
+  {
+    uint8_t v;
+    BENCH(4, v = digitalRead(BENCH_DIGITAL_PIN));
+    benchResult = v;
+  }
+
+  {
+    uint8_t p = benchPin;
+    uint8_t v;
+    BENCH(5, v = digitalRead(p));
+    benchResult = v;
+  }
+
+  {
+    uint8_t p = benchPin;
+    BENCH(6, pinMode(p, OUTPUT));
+  }
+
+  #if NUM_ANALOG_INPUTS > 1
+  {
+    uint16_t v;
+    BENCH(7, v = analogRead(BENCH_ANALOG_CHANNEL));
+    benchResult = v;
+  }
+  #endif
+
+  #if BENCH_HAVE_MILLIS
+  {
+    uint32_t v;
+    BENCH(8, v = millis());
+    benchResult = v;
+    BENCH(9, v = micros());
+    benchResult = v;
+  }
+  #endif
+
+  {
+    uint32_t n = benchLong;
+    BENCH(10, nullPrint.print(n));
+  }
+
+  {
+    uint8_t n = benchByte;
+    BENCH(11, nullPrint.print(n));
+  }
+
+  {
+    uint8_t c = benchByte;
+    BENCH(12, Serial.write(c));
+    Serial.flush();
+  }
+
+  {
+    // Small enough to fit in an empty transmit buffer of the default size,
+    // flush() is outside the measurement so each run starts empty.
+    static const uint8_t buf[8] = { 'b', 'e', 'n', 'c', 'h', '\r', '\n', 0 };
+    for (uint8_t r = 0; r < BENCH_REPEAT; r++) {
+      GPIOR0 = 13;
+      Serial.write(buf, sizeof(buf));
+      GPIOR0 = BENCH_MARKER_STOP;
+      Serial.flush();
+    }
+  }
+
+  GPIOR0 = BENCH_MARKER_DONE;
+}
+
+void loop() {
+}
@@ -0,0 +1,41 @@
+/*
+  bench_ids.h - Benchmark identifiers shared between the CoreBenchmark sketch
+  and the simbench simulator host.
+
+  The sketch signals the start of a measurement by writing the benchmark id
+  to the marker register (GPIOR0), and the end of it by writing
+  BENCH_MARKER_STOP.  When every benchmark has been run it writes
+  BENCH_MARKER_DONE and simbench stops the simulation.
+
+  Ids must be in the range 1..254 and must never be renumbered without also
+  rebuilding simbench, they are the only thing linking a cycle count to a name.
+*/
+
+#ifndef bench_ids_h
+#define bench_ids_h
+
+#define BENCH_MARKER_STOP   0x00
+#define BENCH_MARKER_DONE   0xFF
+
+// Every benchmark is run this many times, simbench reports the minimum (which
+// excludes any time stolen by the millis() interrupt) and the maximum.
+#define BENCH_REPEAT        8
+
+// X(id, name)
+//  overhead must stay first, its minimum is subtracted from all the others
+#define BENCH_LIST(X)                 \
+  X(  1, overhead                   ) \
+  X(  2, digitalWrite_const         ) \
+  X(  3, digitalWrite_var           ) \
+  X(  4, digitalRead_const          ) \
+  X(  5, digitalRead_var            ) \
+  X(  6, pinMode_var                ) \
+  X(  7, analogRead                 ) \
+  X(  8, millis                     ) \
+  X(  9, micros                     ) \
+  X( 10, printNumber_u32            ) \
+  X( 11, printNumber_u8             ) \
+  X( 12, Serial_write               ) \
+  X( 13, Serial_write_buf8          )
+
+#endif
@@ -0,0 +1,85 @@
+#!/bin/bash
+#
+# Compile the CoreBenchmark sketch for every board in boards.list, report the
+# flash/RAM footprint of the core hot paths and run the sketch under simavr to
+# get their cycle counts.
+#
+# Requires: arduino-cli (with this core installed or linked into the
+#   sketchbook hardware folder), avr-gcc/avr-nm/avr-size on the PATH, and
+#   simavr (library and headers) to build the simbench host.
+#
+# Usage: run_benchmarks.sh [label-regex]
+#   only boards whose label matches the (grep -E) regex are run.
+#
+# Environment:
+#   ARDUINO_CLI   arduino-cli command          (default: arduino-cli)
+#   SIMAVR_CFLAGS flags to compile simbench.c  (default: pkg-config simavr)
+#   SIMAVR_LIBS   flags to link simbench       (default: pkg-config simavr)
+#   BENCH_OUT     where build output goes      (default: /tmp/attinycore-benchmark)
+
+here="$(cd "$(dirname "$0")" && pwd)"
+filter="${1:-.}"
+cli="${ARDUINO_CLI:-arduino-cli}"
+out="${BENCH_OUT:-/tmp/attinycore-benchmark}"
+
+# These are the functions we report the size of, matched against the
+# demangled avr-nm output.
+symbols='^(_?digitalWrite|_?digitalRead|_?pinMode|_?analogRead|millis|micros|Print::printNumber\(.*\)|HardwareSerial::write\(unsigned char\)|HardwareSerial::write\(unsigned char const\*, unsigned int\)|TinySoftwareSerial::write\(unsigned char\)|HalfDuplexSerial::write\(unsigned char\)|__vector_[0-9]+)$'
+
+mkdir -p "$out" || exit 1
+
+if [ -z "$SIMAVR_CFLAGS" ]; then SIMAVR_CFLAGS="$(pkg-config --cflags simavr 2>/dev/null || echo -I/usr/include/simavr)"; fi
+if [ -z "$SIMAVR_LIBS" ];   then SIMAVR_LIBS="$(pkg-config --libs simavr 2>/dev/null || echo -lsimavr -lelf)"; fi
+
+simbench="$out/simbench"
+if ! cc -O2 -o "$simbench" $SIMAVR_CFLAGS -I"$here" "$here/simbench.c" $SIMAVR_LIBS; then
+  echo "Unable to build simbench, cycle counts will not be reported." >&2
+  simbench=""
+fi
+
+# The data space address of GPIOR0 on the given mcu.
+marker_address()
+{
+  local def addr
+  def="$(echo '#include <avr/io.h>' | avr-gcc -mmcu="$1" -dM -E -x c - | grep '^#define GPIOR0 ')"
+  addr="$(echo "$def" | grep -o '0x[0-9a-fA-F]*' | head -n 1)"
+  [ -n "$addr" ] || return
+  case "$def" in
+    *_SFR_IO8*) printf '0x%02x\n' $((addr + 0x20)) ;;
+    *)          printf '0x%02x\n' $((addr)) ;;
+  esac
+}
+
+grep -v '^#' "$here/boards.list" | grep -v '^[[:space:]]*$' | while read -r label mcu fcpu fqbn; do
+  echo "$label" | grep -Eq "$filter" || continue
+
+  echo "=== $label ($fqbn)"
+  build="$out/$label"
+  if ! "$cli" compile --fqbn "$fqbn" --build-path "$build" "$here/CoreBenchmark" > "$build.log" 2>&1; then
+    echo "  compile failed, see $build.log"
+    continue
+  fi
+
+  elf="$build/CoreBenchmark.ino.elf"
+
+  avr-size -A "$elf" | awk '$1 == ".text" || $1 == ".data" || $1 == ".bss" { printf "  %-6s %6d bytes\n", $1, $2 }'
+  echo "  -- footprint (bytes)"
+  avr-nm -C --size-sort -S -t d "$elf" \
+    | awk '{ size = $2 + 0; $1 = $2 = $3 = ""; sub(/^ +/, ""); print size "\t" $0 }' \
+    | awk -F '\t' -v re="$symbols" '$2 ~ re { printf "  %-40s %6d\n", $2, $1 }'
+
+  if [ -z "$simbench" ]; then continue; fi
+
+  marker="$(marker_address "$mcu")"
+  if [ -z "$marker" ]; then
+    echo "  -- no GPIOR0 on $mcu, cannot run cycle benchmarks"
+    continue
+  fi
+
+  echo "  -- cycles (min max)"
+  "$simbench" "$mcu" "$fcpu" "$marker" "$elf" | sed 's/^/  /'
+  case "${PIPESTATUS[0]}" in
+    1) echo "  (simavr cannot simulate $mcu)" ;;
+    2) echo "  (sketch did not finish, results are partial)" ;;
+  esac
+done
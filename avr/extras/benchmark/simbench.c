@@ -0,0 +1,141 @@
+/*
+  simbench.c - Run a CoreBenchmark ELF under simavr and report cycle counts.
+
+  Usage: simbench <mcu> <f_cpu> <marker register data address> <elf file>
+
+  The marker register is the data space address (I/O address + 0x20) of
+  GPIOR0 for the mcu, run_benchmarks.sh works it out from avr/io.h.
+
+  The sketch writes a benchmark id to the marker register when a measurement
+  starts and BENCH_MARKER_STOP when it ends, we note the simulator cycle
+  counter on each write.  For every id we keep the smallest and largest
+  count, and the smallest count of the "overhead" benchmark (the cost of the
+  two marker writes themselves) is subtracted from the others.
+
+  Output is one line per benchmark which was run:
+    <name> <min cycles> <max cycles>
+  benchmarks the sketch did not run (not supported on that chip) are omitted.
+
+  Exit status is 0 when the sketch reached BENCH_MARKER_DONE, 1 if the
+  simulator could not be set up for the mcu, 2 if the sketch crashed or ran
+  out of cycles.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "sim_avr.h"
+#include "sim_elf.h"
+#include "sim_io.h"
+
+#include "CoreBenchmark/bench_ids.h"
+
+// Nothing in the benchmark takes anywhere near this long, if we get here the
+// sketch has hung (most likely waiting on a peripheral simavr does not model).
+#define SIMBENCH_MAX_CYCLES 200000000ULL
+
+typedef struct
+{
+  const char        *name;
+  uint8_t            seen;
+  avr_cycle_count_t  min;
+  avr_cycle_count_t  max;
+} bench_result_t;
+
+static bench_result_t     results[256];
+static uint8_t            current_id   = BENCH_MARKER_STOP;
+static avr_cycle_count_t  current_start;
+static uint8_t            done         = 0;
+
+static void marker_write(struct avr_t *avr, avr_io_addr_t addr, uint8_t v, void *param)
+{
+  (void) param;
+  avr->data[addr] = v;
+
+  if (v == BENCH_MARKER_DONE)
+  {
+    done = 1;
+    return;
+  }
+
+  if (v != BENCH_MARKER_STOP)
+  {
+    current_id    = v;
+    current_start = avr->cycle;
+    return;
+  }
+
+  if (current_id == BENCH_MARKER_STOP) return;
+
+  bench_result_t *r = &results[current_id];
+  avr_cycle_count_t c = avr->cycle - current_start;
+  if (!r->seen || c < r->min) r->min = c;
+  if (!r->seen || c > r->max) r->max = c;
+  r->seen = 1;
+
+  current_id = BENCH_MARKER_STOP;
+}
+
+int main(int argc, char *argv[])
+{
+  if (argc != 5)
+  {
+    fprintf(stderr, "Usage: %s <mcu> <f_cpu> <marker address> <elf file>\n", argv[0]);
+    return 1;
+  }
+
+  #define BENCH_NAME(ID, NAME) results[ID].name = #NAME;
+  BENCH_LIST(BENCH_NAME)
+  #undef BENCH_NAME
+
+  elf_firmware_t firmware;
+  memset(&firmware, 0, sizeof(firmware));
+  if (elf_read_firmware(argv[4], &firmware) != 0)
+  {
+    fprintf(stderr, "%s: unable to read %s\n", argv[0], argv[4]);
+    return 1;
+  }
+
+  strncpy(firmware.mmcu, argv[1], sizeof(firmware.mmcu) - 1);
+  firmware.frequency = strtoul(argv[2], NULL, 0);
+
+  avr_t *avr = avr_make_mcu_by_name(firmware.mmcu);
+  if (!avr)
+  {
+    fprintf(stderr, "%s: simavr does not support %s\n", argv[0], firmware.mmcu);
+    return 1;
+  }
+
+  avr_init(avr);
+  avr_load_firmware(avr, &firmware);
+  avr->log = LOG_NONE;
+
+  avr_register_io_write(avr, (avr_io_addr_t) strtoul(argv[3], NULL, 0), marker_write, NULL);
+
+  int state = cpu_Running;
+  while (!done && state != cpu_Done && state != cpu_Crashed && avr->cycle < SIMBENCH_MAX_CYCLES)
+  {
+    state = avr_run(avr);
+  }
+
+  avr_cycle_count_t overhead = results[1].seen ? results[1].min : 0;
+  for (int i = 1; i < 255; i++)
+  {
+    bench_result_t *r = &results[i];
+    if (!r->seen || !r->name) continue;
+    if (i == 1)
+    {
+      printf("%-24s %8llu %8llu\n", r->name, (unsigned long long) r->min, (unsigned long long) r->max);
+    }
+    else
+    {
+      printf("%-24s %8llu %8llu\n", r->name,
+        (unsigned long long) (r->min - overhead),
+        (unsigned long long) (r->max - overhead));
+    }
+  }
+
+  return done ? 0 : 2;
+}
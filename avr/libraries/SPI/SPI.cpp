@@ -443,6 +443,129 @@ void SPIClass::transfer(void* _buf, size_t count) {
     }
 }
 
+// Bulk transfers: the clockout functions above with the byte loop around
+// them, instantiated separately for each direction so that transmit() never
+// reads USIDR back and receive() never loads from a buffer.
+#define USI_TX 1
+#define USI_RX 2
+#define USI_STROBE8(s) s s s s s s s s
+#define USI_STROBE16(s) USI_STROBE8(s) USI_STROBE8(s)
+
+template <uint8_t dir>
+static void bufferUSI2(const uint8_t *tx, uint8_t *rx, size_t count)
+{
+    uint8_t strobe1 = _BV(USIWM0) | _BV(USITC);
+    uint8_t strobe2 = _BV(USIWM0) | _BV(USITC) | _BV(USICLK);
+    uint8_t usicr = USICR;
+    bool mode1 = usicr & _BV(USICS0);
+    USISR = _BV(USIOIF);
+    while (count--) {
+        USIDR = (dir & USI_TX) ? *tx++ : 0xFF;
+        if (!mode1) {
+            asm volatile(USI_STROBE8("out %[usicr], %[strobe1] \n\t"
+                                     "out %[usicr], %[strobe2] \n\t")
+                         :: [usicr] "I" (_SFR_IO_ADDR(USICR)),
+                            [strobe1] "r" (strobe1),
+                            [strobe2] "r" (strobe2));
+        } else {
+            asm volatile("out %[usicr], %[strobe1] \n\t"
+                         "out %[usicr], %[strobe1] \n\t"
+                         "out %[usicr], %[strobe1] \n\t"
+                         "out %[usicr], %[strobe2] \n\t"
+                         "out %[usicr], %[strobe1] \n\t"
+                         "out %[usicr], %[strobe2] \n\t"
+                         "out %[usicr], %[strobe1] \n\t"
+                         "out %[usicr], %[strobe2] \n\t"
+                         "out %[usicr], %[strobe1] \n\t"
+                         "out %[usicr], %[strobe2] \n\t"
+                         "out %[usicr], %[strobe1] \n\t"
+                         "out %[usicr], %[strobe2] \n\t"
+                         "out %[usicr], %[strobe1] \n\t"
+                         "out %[usicr], %[strobe2] \n\t"
+                         "out %[usicr], %[strobe1] \n\t"
+                         "out %[usicr], %[strobe2] \n\t"
+                         :: [usicr] "I" (_SFR_IO_ADDR(USICR)),
+                            [strobe1] "r" (strobe1),
+                            [strobe2] "r" (strobe2));
+        }
+        if (dir & USI_RX) *rx++ = USIDR;
+    }
+    USICR = usicr;
+}
+
+template <uint8_t dir>
+static void bufferUSI4(const uint8_t *tx, uint8_t *rx, size_t count)
+{
+    USISR = _BV(USIOIF);
+    while (count--) {
+        USIDR = (dir & USI_TX) ? *tx++ : 0xFF;
+        asm volatile(USI_STROBE16("sbi %[usicr], %[usitc] \n\t")
+                     :: [usicr] "I" (_SFR_IO_ADDR(USICR)),
+                        [usitc] "I" (USITC));
+        if (dir & USI_RX) *rx++ = USIDR;
+    }
+}
+
+template <uint8_t dir>
+static void bufferUSI8(const uint8_t *tx, uint8_t *rx, size_t count)
+{
+    USISR = _BV(USIOIF);
+    while (count--) {
+        USIDR = (dir & USI_TX) ? *tx++ : 0xFF;
+        asm volatile(USI_STROBE16("sbi %[usicr], %[usitc] \n\t"
+                                  "cbi %[usicr], %[usitc] \n\t")
+                     :: [usicr] "I" (_SFR_IO_ADDR(USICR)),
+                        [usitc] "I" (USITC));
+        if (dir & USI_RX) *rx++ = USIDR;
+    }
+}
+
+template <uint8_t dir>
+static void bufferUSI(const uint8_t *tx, uint8_t *rx, size_t count, uint8_t delay)
+{
+    uint8_t tmp = USICR | _BV(USITC);
+    USISR = _BV(USIOIF);
+    while (count--) {
+        USIDR = (dir & USI_TX) ? *tx++ : 0xFF;
+        for (byte i = 0; i < 16; ++i) {
+            USICR = tmp;
+            _delay_loop_1(delay);
+        }
+        if (dir & USI_RX) *rx++ = USIDR;
+    }
+}
+
+template <uint8_t dir>
+void SPIClass::transferBuffer(const uint8_t *tx, uint8_t *rx, size_t count)
+{
+    if (!msb1st) {
+        while (count--) {
+            uint8_t data = reverse(clockoutfn(reverse((dir & USI_TX) ? *tx++ : 0xFF), delay));
+            if (dir & USI_RX) *rx++ = data;
+        }
+    } else if (clockoutfn == USI_impl::clockoutUSI2) {
+        bufferUSI2<dir>(tx, rx, count);
+    } else if (clockoutfn == USI_impl::clockoutUSI4) {
+        bufferUSI4<dir>(tx, rx, count);
+    } else if (clockoutfn == USI_impl::clockoutUSI8) {
+        bufferUSI8<dir>(tx, rx, count);
+    } else {
+        bufferUSI<dir>(tx, rx, count, delay);
+    }
+}
+
+void SPIClass::transfer(const void *txbuf, void *rxbuf, size_t count) {
+    transferBuffer<USI_TX | USI_RX>((const uint8_t *)txbuf, (uint8_t *)rxbuf, count);
+}
+
+void SPIClass::transmit(const void *buf, size_t count) {
+    transferBuffer<USI_TX>((const uint8_t *)buf, NULL, count);
+}
+
+void SPIClass::receive(void *buf, size_t count) {
+    transferBuffer<USI_RX>(NULL, (uint8_t *)buf, count);
+}
+
 void SPIClass::applySettings(SPISettings settings) {
     USICR = settings.usicr;
     msb1st = settings.msb1st ;
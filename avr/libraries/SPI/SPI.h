@@ -277,6 +277,48 @@ public:
     while (!(SPSR & _BV(SPIF))) ;
     *p = SPDR;
   }
+  // Send txbuf while receiving into rxbuf (which may be the same buffer)
+  inline static void transfer(const void *txbuf, void *rxbuf, size_t count) {
+    if (count == 0) return;
+    const uint8_t *tx = (const uint8_t *)txbuf;
+    uint8_t *rx = (uint8_t *)rxbuf;
+    SPDR = *tx++;
+    while (--count > 0) {
+      uint8_t out = *tx++;
+      while (!(SPSR & _BV(SPIF))) ;
+      uint8_t in = SPDR;
+      SPDR = out;
+      *rx++ = in;
+    }
+    while (!(SPSR & _BV(SPIF))) ;
+    *rx = SPDR;
+  }
+  // Send buf, ignoring what comes back
+  inline static void transmit(const void *buf, size_t count) {
+    if (count == 0) return;
+    const uint8_t *p = (const uint8_t *)buf;
+    SPDR = *p++;
+    while (--count > 0) {
+      uint8_t out = *p++;
+      while (!(SPSR & _BV(SPIF))) ;
+      SPDR = out;
+    }
+    while (!(SPSR & _BV(SPIF))) ;
+  }
+  // Receive into buf, sending 0xFF
+  inline static void receive(void *buf, size_t count) {
+    if (count == 0) return;
+    uint8_t *p = (uint8_t *)buf;
+    SPDR = 0xFF;
+    while (--count > 0) {
+      while (!(SPSR & _BV(SPIF))) ;
+      uint8_t in = SPDR;
+      SPDR = 0xFF;
+      *p++ = in;
+    }
+    while (!(SPSR & _BV(SPIF))) ;
+    *p = SPDR;
+  }
   // After performing a group of transfers and releasing the chip select
   // signal, this function allows others to access the SPI bus
   inline static void endTransaction(void) {
@@ -441,6 +483,12 @@ class SPIClass
   static uint8_t transfer(uint8_t data);
   static uint16_t transfer16(uint16_t data);
   static void transfer(void *buf, size_t count);
+  // Bulk transfers with the clock strobes unrolled, no call per byte, and no
+  // USIDR read-back (transmit) or buffer load (receive, sends 0xFF) when not
+  // needed. transfer() may be given the same buffer twice.
+  static void transfer(const void *txbuf, void *rxbuf, size_t count);
+  static void transmit(const void *buf, size_t count);
+  static void receive(void *buf, size_t count);
   static void endTransaction(void);
   static void end();
 
@@ -465,6 +513,8 @@ class SPIClass
 
 private:
   static void applySettings(SPISettings settings);
+  template <uint8_t dir>
+  static void transferBuffer(const uint8_t *tx, uint8_t *rx, size_t count);
 
   static uint8_t msb1st;
   static uint8_t delay;
@@ -142,6 +142,47 @@ public:
     return quantity;
   }
 
+  // Streaming transfers for Wire.beginWrite() and friends. Nothing is
+  // buffered here anyway, so they just don't stop at BUFFER_LENGTH.
+  uint8_t beginWrite(uint8_t address) {
+    beginTransmission(address);
+    uint8_t transError = error;
+    error = 0;
+    if (transError) {
+      i2c_stop();
+      transmitting = 0;
+    }
+    return transError;
+  }
+
+  uint8_t writeChunk(const uint8_t *data, size_t length) {
+    while (length--) {
+      if (!i2c_write(*data++)) {
+        i2c_stop();
+        transmitting = 0;
+        return 3;
+      }
+    }
+    return 0;
+  }
+
+  size_t readInto(uint8_t address, uint8_t *buffer, size_t length, uint8_t sendStop) {
+    if (length == 0) return 0;
+    bool acked = i2c_rep_start((address<<1) | I2C_READ);
+    transmitting = 1;
+    if (!acked) {
+      length = 0;
+      sendStop = true;
+    }
+    for (size_t left = length; left; left--)
+      *buffer++ = i2c_read(left == 1);
+    if (sendStop) {
+      transmitting = 0;
+      i2c_stop();
+    }
+    return length;
+  }
+
   uint8_t requestFrom(uint8_t address, uint8_t quantity, uint8_t sendStop) {
   return requestFrom((uint8_t)address, (uint8_t)quantity, (uint32_t)0, (uint8_t)0, (uint8_t)sendStop);
   }
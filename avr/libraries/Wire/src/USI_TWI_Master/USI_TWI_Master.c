@@ -32,8 +32,7 @@
 #include "USI_TWI_Master.h"
 
 unsigned char USI_TWI_Master_Transfer(unsigned char);
-unsigned char USI_TWI_Master_Stop(void);
-static unsigned char USI_TWI_MASTER_SPEED=0;
+unsigned char USI_TWI_MASTER_SPEED=0;
 
 union USI_TWI_state {
   unsigned char errorState; // Can reuse the TWI_state for error states due to that it will not be need if there
@@ -45,8 +44,28 @@ union USI_TWI_state {
   };
 } USI_TWI_state;
 
-void USI_TWI_Master_Speed(uint8_t fm) {
-  USI_TWI_MASTER_SPEED=fm?1:0;
+void USI_TWI_Master_Speed(uint8_t mode) {
+  USI_TWI_MASTER_SPEED = mode > USI_TWI_FAST_MODE_PLUS ? USI_TWI_FAST_MODE_PLUS : mode;
+}
+
+/*---------------------------------------------------------------
+ The two halves of an SCL period.  The delays have to be compile
+ time constants to be cycle exact, hence one of each per speed.
+---------------------------------------------------------------*/
+static inline void USI_TWI_Delay_Low(void) __attribute__((always_inline));
+static inline void USI_TWI_Delay_Low(void)
+{
+  if (USI_TWI_MASTER_SPEED == USI_TWI_STANDARD_MODE) USI_TWI_DELAY(T_LOW_SM);
+  else if (USI_TWI_MASTER_SPEED == USI_TWI_FAST_MODE) USI_TWI_DELAY(T_LOW_FM);
+  else USI_TWI_DELAY(T_LOW_FMP);
+}
+
+static inline void USI_TWI_Delay_High(void) __attribute__((always_inline));
+static inline void USI_TWI_Delay_High(void)
+{
+  if (USI_TWI_MASTER_SPEED == USI_TWI_STANDARD_MODE) USI_TWI_DELAY(T_HIGH_SM);
+  else if (USI_TWI_MASTER_SPEED == USI_TWI_FAST_MODE) USI_TWI_DELAY(T_HIGH_FM);
+  else USI_TWI_DELAY(T_HIGH_FMP);
 }
 
 /*---------------------------------------------------------------
@@ -106,12 +125,6 @@ unsigned char USI_TWI_Start_Transceiver_With_Data(unsigned char *msg, unsigned c
 
 unsigned char USI_TWI_Start_Transceiver_With_Data_Stop(unsigned char *msg, unsigned char msgSize, unsigned char stop)
 {
-  unsigned char tempUSISR_8bit = (1 << USISIF) | (1 << USIOIF) | (1 << USIPF) | (1 << USIDC) | (0x0 << USICNT0);
-  // Prepare register value to: Clear flags set USI to shift 8 bits i.e. count 16 clock edges.
-
-  unsigned char tempUSISR_1bit = (1 << USISIF) | (1 << USIOIF) | (1 << USIPF) | (1 << USIDC) | (0xE << USICNT0);
-  // Prepare register value to: Clear flags, and set USI to shift 1 bit i.e. count 2 clock edges.
-
   USI_TWI_state.errorState  = 0;
   USI_TWI_state.addressMode = TRUE;
 
@@ -148,40 +161,14 @@ unsigned char USI_TWI_Start_Transceiver_With_Data_Stop(unsigned char *msg, unsig
     USI_TWI_state.masterWriteDataMode = TRUE;
   }
 
-  /* Release SCL to ensure that (repeated) Start can be performed */
-  PORT_USI_CL |= (1 << PIN_USI_SCL); // Release SCL.
-  while (!(PIN_USI_CL & (1 << PIN_USI_SCL)))
-    ; // Verify that SCL becomes high.
-  if (USI_TWI_MASTER_SPEED) DELAY_T4TWI_FM; // Delay for T4TWI if TWI_FAST_MODE
-  else DELAY_T2TWI;    // Delay for T2TWI if TWI_STANDARD_MODE
-
-  /* Generate Start Condition */
-  PORT_USI &= ~(1 << PIN_USI_SDA); // Force SDA LOW.
-
-  if (USI_TWI_MASTER_SPEED) DELAY_T4TWI_FM; else DELAY_T4TWI; // UGGGGLLLYYYYY - but if you never call clock() which is the only thing that could change USI_TWI_MASTER_SPEED, should be optimized out
-
-  PORT_USI_CL &= ~(1 << PIN_USI_SCL); // Pull SCL LOW.
-  PORT_USI |= (1 << PIN_USI_SDA);  // Release SDA.
-
-#ifdef SIGNAL_VERIFY
-  if (!(USISR & (1 << USISIF))) {
-    USI_TWI_state.errorState = USI_TWI_MISSING_START_CON;
+  if (!USI_TWI_Master_Start())
     return (FALSE);
-  }
-#endif
 
   /*Write address and Read/Write data */
   do {
     /* If masterWrite cycle (or initial address transmission)*/
     if (USI_TWI_state.addressMode || USI_TWI_state.masterWriteDataMode) {
-      /* Write a byte */
-      PORT_USI_CL &= ~(1 << PIN_USI_SCL);         // Pull SCL LOW.
-      USIDR = *(msg++);                        // Setup data.
-      USI_TWI_Master_Transfer(tempUSISR_8bit); // Send 8 bits on bus.
-
-      /* Clock and verify (N)ACK from slave */
-      DDR_USI &= ~(1 << PIN_USI_SDA); // Enable SDA as input.
-      if (USI_TWI_Master_Transfer(tempUSISR_1bit) & (1 << TWI_NACK_BIT)) {
+      if (!USI_TWI_Master_Write_Byte(*(msg++))) {
         if (USI_TWI_state.addressMode)
           USI_TWI_state.errorState = USI_TWI_NO_ACK_ON_ADDRESS;
         else
@@ -192,18 +179,8 @@ unsigned char USI_TWI_Start_Transceiver_With_Data_Stop(unsigned char *msg, unsig
     }
     /* Else masterRead cycle*/
     else {
-      /* Read a data byte */
-      DDR_USI &= ~(1 << PIN_USI_SDA); // Enable SDA as input.
-      *(msg++) = USI_TWI_Master_Transfer(tempUSISR_8bit);
-
-      /* Prepare to generate ACK (or NACK in case of End Of Transmission) */
-      if (msgSize == 1) // If transmission of last byte was performed.
-      {
-        USIDR = 0xFF; // Load NACK to confirm End Of Transmission.
-      } else {
-        USIDR = 0x00; // Load ACK. Set data register bit 7 (output for SDA) low.
-      }
-      USI_TWI_Master_Transfer(tempUSISR_1bit); // Generate ACK/NACK.
+      /* Read a data byte, NACK the last one to confirm End Of Transmission */
+      *(msg++) = USI_TWI_Master_Read_Byte(msgSize == 1);
     }
   } while (--msgSize); // Until all data sent/received.
 
@@ -215,6 +192,64 @@ unsigned char USI_TWI_Start_Transceiver_With_Data_Stop(unsigned char *msg, unsig
   return (TRUE);
 }
 
+/*---------------------------------------------------------------
+ Function for generating a TWI (Repeated) Start Condition. Leaves
+ SCL held low, ready for the address byte.
+---------------------------------------------------------------*/
+unsigned char USI_TWI_Master_Start(void)
+{
+  /* Release SCL to ensure that (repeated) Start can be performed */
+  PORT_USI_CL |= (1 << PIN_USI_SCL); // Release SCL.
+  while (!(PIN_USI_CL & (1 << PIN_USI_SCL)))
+    ; // Verify that SCL becomes high.
+  USI_TWI_Delay_Low(); // Start condition setup time.
+
+  /* Generate Start Condition */
+  PORT_USI &= ~(1 << PIN_USI_SDA); // Force SDA LOW.
+
+  USI_TWI_Delay_High(); // Start condition hold time.
+
+  PORT_USI_CL &= ~(1 << PIN_USI_SCL); // Pull SCL LOW.
+  PORT_USI |= (1 << PIN_USI_SDA);  // Release SDA.
+
+#ifdef SIGNAL_VERIFY
+  if (!(USISR & (1 << USISIF))) {
+    USI_TWI_state.errorState = USI_TWI_MISSING_START_CON;
+    return (FALSE);
+  }
+#endif
+
+  return (TRUE);
+}
+
+/*---------------------------------------------------------------
+ Writes a byte, and clocks in the (N)ACK from the slave. Returns
+ TRUE if it was ACKed.
+---------------------------------------------------------------*/
+unsigned char USI_TWI_Master_Write_Byte(unsigned char data)
+{
+  PORT_USI_CL &= ~(1 << PIN_USI_SCL);          // Pull SCL LOW.
+  USIDR = data;                                // Setup data.
+  USI_TWI_Master_Transfer(USI_TWI_USISR_8BIT); // Send 8 bits on bus.
+
+  DDR_USI &= ~(1 << PIN_USI_SDA); // Enable SDA as input.
+  return !(USI_TWI_Master_Transfer(USI_TWI_USISR_1BIT) & (1 << TWI_NACK_BIT));
+}
+
+/*---------------------------------------------------------------
+ Reads a byte, and sends ACK, or NACK if it is the last one.
+---------------------------------------------------------------*/
+unsigned char USI_TWI_Master_Read_Byte(unsigned char last)
+{
+  unsigned char data;
+  DDR_USI &= ~(1 << PIN_USI_SDA); // Enable SDA as input.
+  data = USI_TWI_Master_Transfer(USI_TWI_USISR_8BIT);
+
+  USIDR = last ? 0xFF : 0x00;                  // Load NACK or ACK (SDA low).
+  USI_TWI_Master_Transfer(USI_TWI_USISR_1BIT); // Generate ACK/NACK.
+  return data;
+}
+
 /*---------------------------------------------------------------
  Core function for shifting data in and out from the USI.
  Data to be sent has to be placed into the USIDR prior to calling
@@ -229,15 +264,15 @@ unsigned char USI_TWI_Master_Transfer(unsigned char temp)
          (1 << USICS1) | (0 << USICS0) | (1 << USICLK) | // Software clock strobe as source.
          (1 << USITC);                                   // Toggle Clock Port.
   do {
-    if (USI_TWI_MASTER_SPEED) DELAY_T2TWI_FM; else DELAY_T2TWI;
+    USI_TWI_Delay_Low();
     USICR = temp; // Generate positive SCL edge.
     while (!(PIN_USI_CL & (1 << PIN_USI_SCL)))
       ; // Wait for SCL to go high.
-    if (USI_TWI_MASTER_SPEED) DELAY_T4TWI_FM; else DELAY_T4TWI;
+    USI_TWI_Delay_High();
     USICR = temp;                   // Generate negative SCL edge.
   } while (!(USISR & (1 << USIOIF))); // Check for transfer complete.
 
-  if (USI_TWI_MASTER_SPEED) DELAY_T2TWI_FM; else DELAY_T2TWI;
+  USI_TWI_Delay_Low();
   temp  = USIDR;                 // Read out data.
   USIDR = 0xFF;                  // Release SDA.
   DDR_USI |= (1 << PIN_USI_SDA); // Enable SDA as output.
@@ -255,9 +290,9 @@ unsigned char USI_TWI_Master_Stop(void)
   PORT_USI_CL |= (1 << PIN_USI_SCL);  // Release SCL.
   while (!(PIN_USI_CL & (1 << PIN_USI_SCL)))
     ; // Wait for SCL to go high.
-  if (USI_TWI_MASTER_SPEED) DELAY_T4TWI_FM; else DELAY_T4TWI;
+  USI_TWI_Delay_High(); // Stop condition setup time.
   PORT_USI |= (1 << PIN_USI_SDA); // Release SDA.
-  if (USI_TWI_MASTER_SPEED) DELAY_T2TWI_FM; else DELAY_T2TWI;
+  USI_TWI_Delay_Low();  // Bus free time before the next start.
 
 #ifdef SIGNAL_VERIFY
   if (!(USISR & (1 << USIPF))) {
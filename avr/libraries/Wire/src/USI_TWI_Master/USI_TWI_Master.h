@@ -27,18 +27,39 @@
 
 #include <avr/io.h>
 #ifndef TWDR
-#include <util/delay_basic.h>
 
 //********** Defines **********//
-// Generalized way of getting a correct delay that is acceptable by standard or fast mode I2C
-// round up to nearest 1mhz if not even multiple of 1 MHz and divide by 1000000 to get clock/us rounded up (safe)
-// these are the number of passes through _delay_loop1()
-#define CLKBASE ((F_CPU+999999)/1000000)
-#define T2_TWI (5*CLKBASE) //5us
-#define T4_TWI (4*CLKBASE) //4us
-// these all err in the direction of being too slow, which is fine
-#define T2_TWI_FM (2*CLKBASE-(CLKBASE>>1)) //1.5us
-#define T4_TWI_FM (CLKBASE-(CLKBASE>>2)) //0.75us
+// SCL timing from the I2C spec, in clock cycles rounded up, for standard mode
+// (100 kHz), fast mode (400 kHz) and fast mode plus (1 MHz).  The low half is
+// the minimum SCL low time, and the high half is whatever is left of the full
+// period (10 us, 2.5 us, 1 us), which is more than the minimum high time, so
+// the clock does not run faster than the mode allows.  The low half also covers
+// the setup time before a (repeated) start or a stop, and the high half the
+// hold time after a start.
+#define USI_TWI_CYCLES(ns) ((((F_CPU / 1000UL) * (ns)) + 999999UL) / 1000000UL)
+#define T_LOW_SM   USI_TWI_CYCLES(4700)
+#define T_HIGH_SM  USI_TWI_CYCLES(10000 - 4700)
+#define T_LOW_FM   USI_TWI_CYCLES(1300)
+#define T_HIGH_FM  USI_TWI_CYCLES(2500 - 1300)
+#define T_LOW_FMP  USI_TWI_CYCLES(500)
+#define T_HIGH_FMP USI_TWI_CYCLES(1000 - 500)
+
+// Roughly what the code between two SCL edges takes already, so that it is not
+// waited for twice.  At fast mode plus this is often all there is, and then the
+// bus just runs as fast as the chip can go.
+#define USI_TWI_OVERHEAD 6
+#define USI_TWI_DELAY(cycles) do { if ((cycles) > USI_TWI_OVERHEAD) \
+    __builtin_avr_delay_cycles((cycles) > USI_TWI_OVERHEAD ? (cycles) - USI_TWI_OVERHEAD : 1); } while (0)
+
+// USISR values to clear the flags and shift 8 bits (count 16 clock edges)
+// or 1 bit (count 2 clock edges)
+#define USI_TWI_USISR_8BIT ((1 << USISIF) | (1 << USIOIF) | (1 << USIPF) | (1 << USIDC) | (0x0 << USICNT0))
+#define USI_TWI_USISR_1BIT ((1 << USISIF) | (1 << USIOIF) | (1 << USIPF) | (1 << USIDC) | (0xE << USICNT0))
+
+// Values for USI_TWI_Master_Speed()
+#define USI_TWI_STANDARD_MODE  0
+#define USI_TWI_FAST_MODE      1
+#define USI_TWI_FAST_MODE_PLUS 2
 
 // Defines controlling code generating
 //#define PARAM_VERIFICATION
@@ -72,10 +93,6 @@
 #define TRUE 1
 #define FALSE 0
 
-#define DELAY_T2TWI_FM (_delay_loop_1(T2_TWI_FM / 3))
-#define DELAY_T4TWI_FM (_delay_loop_1(T4_TWI_FM / 3))
-#define DELAY_T2TWI (_delay_loop_1(T2_TWI / 3))
-#define DELAY_T4TWI (_delay_loop_1(T4_TWI / 3))
 //********** Prototypes **********//
 
 void USI_TWI_Master_Initialise(void);
@@ -83,4 +100,15 @@ void USI_TWI_Master_Speed(uint8_t);
 unsigned char USI_TWI_Start_Transceiver_With_Data_Stop(unsigned char *, unsigned char, unsigned char);
 unsigned char USI_TWI_Start_Transceiver_With_Data(unsigned char *, unsigned char);
 unsigned char USI_TWI_Get_State_Info(void);
+unsigned char USI_TWI_Master_Start(void);
+unsigned char USI_TWI_Master_Stop(void);
+unsigned char USI_TWI_Master_Write_Byte(unsigned char);
+unsigned char USI_TWI_Master_Read_Byte(unsigned char);
+extern unsigned char USI_TWI_MASTER_SPEED;
+
+// Interrupt driven transfers, see USI_TWI_Master_Async.c
+#define USI_TWI_BUSY 0x09              // An asynchronous transfer is still running
+unsigned char USI_TWI_Start_Transceiver_Async(unsigned char *, unsigned char, unsigned char, void (*)(unsigned char));
+unsigned char USI_TWI_Master_Async_Busy(void);
+unsigned char USI_TWI_Master_Async_Overflow(void);
 #endif
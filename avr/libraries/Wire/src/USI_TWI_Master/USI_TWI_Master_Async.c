@@ -0,0 +1,343 @@
+/*
+  USI_TWI_Master_Async.c - interrupt driven transfers for the USI TWI master
+  Part of ATTinyCore
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General
+  Public License along with this library; if not, write to the
+  Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+  Boston, MA  02111-1307  USA
+
+  The USI can shift the bits, but only software can toggle SCL (USITC).
+  Here Timer1 runs in CTC mode at twice the bus clock, and its compare
+  interrupt does nothing but strobe USITC, so the busy waits of
+  USI_TWI_Start_Transceiver_With_Data_Stop() become interrupts.  When the
+  counter overflows at the end of a byte or an (N)ACK bit, the USI overflow
+  interrupt steps the state machine below, which sets up the next one or
+  finishes and calls the completion callback.
+
+  Timer0 can't do this: it is the millis timer, it runs at /64, and in the
+  PWM modes OCR0x only changes once per timer cycle.  Timer1 belongs to the
+  transfer while it runs (no PWM on its pins), its registers are put back
+  afterwards, and its compare A vector is taken, so this can't be used in the
+  same sketch as tone() or the interrupt driven software serial on Timer1.
+  The library is linked as an archive, so none of this is in a sketch unless
+  the asynchronous functions are used.
+
+  Each SCL edge costs an interrupt of about 20 clocks, so the half period is
+  never made shorter than USI_TWI_ASYNC_MIN_CYCLES; 100 kHz is fine, but
+  fast mode and fast mode plus run at whatever that allows.  For full speed
+  use the blocking functions.
+*/
+
+#include <avr/io.h>
+
+#ifdef USIDR
+#include "Arduino.h"
+#include <avr/interrupt.h>
+#include "USI_TWI_Master.h"
+
+#if (defined(TCCR1) || defined(WGM12)) && defined(OCR1A) && (TIMER_TO_USE_FOR_MILLIS != 1)
+
+#if !defined(TIMER1_COMPA_vect) && defined(TIM1_COMPA_vect)
+  #define TIMER1_COMPA_vect TIM1_COMPA_vect
+#endif
+
+#if defined(TIMSK1)
+  #define USI_TWI_TIMSK TIMSK1
+#else
+  #define USI_TWI_TIMSK TIMSK
+#endif
+
+/* On the x5 Timer1 can run from the PLL */
+#if defined(PLLTIMER1)
+  #define USI_TWI_TIMER_CLOCK 64000000UL
+#elif defined(LOWPLLTIMER1)
+  #define USI_TWI_TIMER_CLOCK 32000000UL
+#else
+  #define USI_TWI_TIMER_CLOCK F_CPU
+#endif
+
+// Shortest half period of SCL, in CPU clocks, that leaves the sketch some time
+#define USI_TWI_ASYNC_MIN_CYCLES 48
+
+// Software clock strobe, as USI_TWI_Master_Transfer() uses, plus the overflow
+// interrupt.  Writing this toggles SCL; without USITC it just sets the mode.
+#define USI_TWI_ASYNC_USICR  ((1 << USIOIE) | (1 << USIWM1) | (1 << USICS1) | (1 << USICLK))
+#define USI_TWI_ASYNC_STROBE (USI_TWI_ASYNC_USICR | (1 << USITC))
+
+// What the byte or bit which just finished was
+#define USI_TWI_ASYNC_IDLE        0
+#define USI_TWI_ASYNC_ADDRESS     1
+#define USI_TWI_ASYNC_ADDRESS_ACK 2
+#define USI_TWI_ASYNC_SEND        3
+#define USI_TWI_ASYNC_SEND_ACK    4
+#define USI_TWI_ASYNC_READ        5
+#define USI_TWI_ASYNC_READ_ACK    6
+
+static volatile unsigned char USI_TWI_Async_State;
+static unsigned char *USI_TWI_Async_Msg;  // the next byte to send or receive
+static unsigned char USI_TWI_Async_Left;  // bytes not yet finished, address included
+static unsigned char USI_TWI_Async_Read;
+static unsigned char USI_TWI_Async_Stop;
+static void (*USI_TWI_Async_Done)(unsigned char);
+
+static uint8_t USI_TWI_Async_Saved_Mask;
+#if defined(TCCR1)
+static uint8_t USI_TWI_Async_Saved_TCCR1, USI_TWI_Async_Saved_OCR1A, USI_TWI_Async_Saved_OCR1C;
+#else
+static uint8_t USI_TWI_Async_Saved_TCCR1A, USI_TWI_Async_Saved_TCCR1B;
+static uint16_t USI_TWI_Async_Saved_OCR1A;
+#endif
+
+/*---------------------------------------------------------------
+ Half the SCL period of the current speed, in timer clocks. Both
+ halves are made as long as the longer of the low and high time.
+---------------------------------------------------------------*/
+static uint16_t USI_TWI_Async_Half_Period(void)
+{
+  uint32_t cycles;
+  if (USI_TWI_MASTER_SPEED == USI_TWI_STANDARD_MODE) cycles = T_LOW_SM > T_HIGH_SM ? T_LOW_SM : T_HIGH_SM;
+  else if (USI_TWI_MASTER_SPEED == USI_TWI_FAST_MODE) cycles = T_LOW_FM > T_HIGH_FM ? T_LOW_FM : T_HIGH_FM;
+  else cycles = T_LOW_FMP > T_HIGH_FMP ? T_LOW_FMP : T_HIGH_FMP;
+  if (cycles < USI_TWI_ASYNC_MIN_CYCLES) cycles = USI_TWI_ASYNC_MIN_CYCLES;
+  return cycles * (USI_TWI_TIMER_CLOCK / 1000UL) / (F_CPU / 1000UL);
+}
+
+static void USI_TWI_Async_Timer_Start(void)
+{
+  uint16_t half = USI_TWI_Async_Half_Period();
+  USI_TWI_Async_Saved_Mask = USI_TWI_TIMSK;
+  #if defined(TCCR1)
+  // x5: the clock select bits divide by 2^(n-1), and OCR1C is the top
+  uint8_t cs = 1;
+  while (half > 256) {
+    half = (half + 1) >> 1;
+    cs++;
+  }
+  USI_TWI_Async_Saved_TCCR1 = TCCR1;
+  USI_TWI_Async_Saved_OCR1A = OCR1A;
+  USI_TWI_Async_Saved_OCR1C = OCR1C;
+  TCCR1 = 0;
+  TCNT1 = 0;
+  OCR1C = half - 1;
+  OCR1A = half - 1;
+  TIFR  = (1 << OCF1A);
+  TCCR1 = (1 << CTC1) | cs;
+  #else
+  USI_TWI_Async_Saved_TCCR1A = TCCR1A;
+  USI_TWI_Async_Saved_TCCR1B = TCCR1B;
+  USI_TWI_Async_Saved_OCR1A  = OCR1A;
+  TCCR1B = 0;
+  TCCR1A = 0;
+  TCNT1  = 0;
+  OCR1A  = half - 1;
+  #if defined(TIFR1)
+  TIFR1  = (1 << OCF1A);
+  #else
+  TIFR   = (1 << OCF1A);
+  #endif
+  TCCR1B = (1 << WGM12) | (1 << CS10);
+  #endif
+  USI_TWI_TIMSK |= (1 << OCIE1A);
+}
+
+static void USI_TWI_Async_Timer_Stop(void)
+{
+  #if defined(TCCR1)
+  TCCR1 = USI_TWI_Async_Saved_TCCR1;
+  OCR1A = USI_TWI_Async_Saved_OCR1A;
+  OCR1C = USI_TWI_Async_Saved_OCR1C;
+  #else
+  TCCR1B = USI_TWI_Async_Saved_TCCR1B;
+  TCCR1A = USI_TWI_Async_Saved_TCCR1A;
+  OCR1A  = USI_TWI_Async_Saved_OCR1A;
+  #endif
+  USI_TWI_TIMSK = USI_TWI_Async_Saved_Mask;
+}
+
+/*---------------------------------------------------------------
+ Starts a transfer like USI_TWI_Start_Transceiver_With_Data_Stop()
+ and returns straight away. The start condition is still sent
+ here, the rest happens in the interrupts, and done() is called
+ from the USI overflow interrupt with 0 or the error code once
+ it is over. msg must stay untouched until then.
+
+ Returns 0 if the transfer started, USI_TWI_BUSY if the last one
+ is still running or USI_TWI_MISSING_START_CON.
+---------------------------------------------------------------*/
+unsigned char USI_TWI_Start_Transceiver_Async(unsigned char *msg, unsigned char msgSize, unsigned char stop, void (*done)(unsigned char))
+{
+  if (USI_TWI_Async_State != USI_TWI_ASYNC_IDLE)
+    return USI_TWI_BUSY;
+  if (!USI_TWI_Master_Start())
+    return USI_TWI_Get_State_Info();
+
+  USI_TWI_Async_Msg   = msg + 1;
+  USI_TWI_Async_Left  = msgSize;
+  USI_TWI_Async_Read  = *msg & (1 << TWI_READ_BIT);
+  USI_TWI_Async_Stop  = stop;
+  USI_TWI_Async_Done  = done;
+  USI_TWI_Async_State = USI_TWI_ASYNC_ADDRESS;
+
+  uint8_t oldSREG = SREG;
+  cli();
+  USIDR = *msg;
+  USISR = USI_TWI_USISR_8BIT;
+  USICR = USI_TWI_ASYNC_USICR;
+  USI_TWI_Async_Timer_Start();
+  SREG = oldSREG;
+  return 0;
+}
+
+unsigned char USI_TWI_Master_Async_Busy(void)
+{
+  return USI_TWI_Async_State != USI_TWI_ASYNC_IDLE;
+}
+
+static void USI_TWI_Async_Finish(unsigned char status)
+{
+  USI_TWI_Async_Timer_Stop();
+  USICR = (1 << USIWM1) | (1 << USICS1) | (1 << USICLK); // Interrupts off again.
+  USISR = USI_TWI_USISR_8BIT;
+  // Unlike the blocking version, a NACK still gets a stop, so that the bus
+  // is not left with SCL held low.
+  if (status || USI_TWI_Async_Stop)
+    USI_TWI_Master_Stop();
+  USI_TWI_Async_State = USI_TWI_ASYNC_IDLE;
+  if (USI_TWI_Async_Done)
+    USI_TWI_Async_Done(status);
+}
+
+/*---------------------------------------------------------------
+ Called from the USI overflow interrupt, which lives with the
+ slave. Returns FALSE if no transfer is running, so the slave
+ should handle it.
+---------------------------------------------------------------*/
+unsigned char USI_TWI_Master_Async_Overflow(void)
+{
+  unsigned char state = USI_TWI_Async_State;
+  if (state == USI_TWI_ASYNC_IDLE)
+    return FALSE;
+
+  // SCL is low, and stays low until USIOIF is cleared by the write to USISR
+  // at the end, because the compare interrupt checks it.
+  unsigned char data = USIDR;
+  unsigned char count = USI_TWI_USISR_8BIT;
+  USIDR = 0xFF;                  // Release SDA.
+  DDR_USI |= (1 << PIN_USI_SDA); // Enable SDA as output.
+
+  switch (state) {
+  case USI_TWI_ASYNC_ADDRESS:
+  case USI_TWI_ASYNC_SEND:
+    // Clock in the (N)ACK from the slave
+    DDR_USI &= ~(1 << PIN_USI_SDA);
+    state++;
+    count = USI_TWI_USISR_1BIT;
+    break;
+  case USI_TWI_ASYNC_ADDRESS_ACK:
+  case USI_TWI_ASYNC_SEND_ACK:
+    if (data & (1 << TWI_NACK_BIT)) {
+      USI_TWI_Async_Finish(state == USI_TWI_ASYNC_ADDRESS_ACK ? USI_TWI_NO_ACK_ON_ADDRESS : USI_TWI_NO_ACK_ON_DATA);
+      return TRUE;
+    }
+    if (!--USI_TWI_Async_Left) {
+      USI_TWI_Async_Finish(0);
+      return TRUE;
+    }
+    if (USI_TWI_Async_Read) {
+      DDR_USI &= ~(1 << PIN_USI_SDA);
+      state = USI_TWI_ASYNC_READ;
+    } else {
+      USIDR = *USI_TWI_Async_Msg++;
+      state = USI_TWI_ASYNC_SEND;
+    }
+    break;
+  case USI_TWI_ASYNC_READ:
+    *USI_TWI_Async_Msg++ = data;
+    // ACK, or NACK to end the transfer after the last byte
+    USIDR = (USI_TWI_Async_Left == 1) ? 0xFF : 0x00;
+    state = USI_TWI_ASYNC_READ_ACK;
+    count = USI_TWI_USISR_1BIT;
+    break;
+  default: // USI_TWI_ASYNC_READ_ACK
+    if (!--USI_TWI_Async_Left) {
+      USI_TWI_Async_Finish(0);
+      return TRUE;
+    }
+    DDR_USI &= ~(1 << PIN_USI_SDA);
+    state = USI_TWI_ASYNC_READ;
+    break;
+  }
+  USI_TWI_Async_State = state;
+  USISR = count;
+  return TRUE;
+}
+
+/*
+  One SCL edge.  Nothing here touches SREG, so it needs no prologue: if the
+  overflow interrupt has not stepped the state machine yet, it waits; if SCL
+  was released but is still low, the slave is stretching the clock and it
+  waits too; otherwise it strobes USITC.
+*/
+ISR(TIMER1_COMPA_vect, ISR_NAKED)
+{
+  __asm__ __volatile__ (
+    "   push r24\n"
+    "   lds  r24, %[usisr]\n"
+    "   sbrc r24, %[usioif]\n"
+    "   rjmp 2f\n"
+    "   sbis %[port], %[scl]\n"
+    "   rjmp 1f\n"
+    "   sbis %[pin], %[scl]\n"
+    "   rjmp 2f\n"
+    "1: ldi  r24, %[strobe]\n"
+    "   sts  %[usicr], r24\n"
+    "2: pop  r24\n"
+    "   reti\n"
+    ::
+      [usisr]  "n" (_SFR_MEM_ADDR(USISR)),
+      [usicr]  "n" (_SFR_MEM_ADDR(USICR)),
+      [usioif] "I" (USIOIF),
+      [port]   "I" (_SFR_IO_ADDR(PORT_USI_CL)),
+      [pin]    "I" (_SFR_IO_ADDR(PIN_USI_CL)),
+      [scl]    "I" (PIN_USI_SCL),
+      [strobe] "M" (USI_TWI_ASYNC_STROBE)
+  );
+}
+
+#else
+/*---------------------------------------------------------------
+ No Timer1 to pace the clock (or it is the millis timer): fall
+ back to a blocking transfer, and call done() before returning.
+---------------------------------------------------------------*/
+unsigned char USI_TWI_Start_Transceiver_Async(unsigned char *msg, unsigned char msgSize, unsigned char stop, void (*done)(unsigned char))
+{
+  unsigned char status = 0;
+  if (!USI_TWI_Start_Transceiver_With_Data_Stop(msg, msgSize, stop))
+    status = USI_TWI_Get_State_Info();
+  if (done)
+    done(status);
+  return 0;
+}
+
+unsigned char USI_TWI_Master_Async_Busy(void)
+{
+  return FALSE;
+}
+
+unsigned char USI_TWI_Master_Async_Overflow(void)
+{
+  return FALSE;
+}
+#endif
+#endif
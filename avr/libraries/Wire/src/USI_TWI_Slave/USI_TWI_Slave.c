@@ -37,9 +37,23 @@ uint8_t TWI_Buffer[TWI_BUFFER_SIZE];
 
 //********** Static Variables **********//
 
-static unsigned char          TWI_slaveAddress;
 static volatile unsigned char USI_TWI_Overflow_State;
 
+// Address byte as it is shifted in (address << 1), and the bits of it which
+// have to match; kept preshifted for the reject path in the overflow vector.
+static unsigned char          TWI_addressCompare;
+static unsigned char          TWI_addressCare = 0xFE;
+static volatile unsigned char TWI_matchedAddress;
+
+// Register map mode: the first byte written sets the register pointer,
+// further bytes go into (or are read from) the map, with no buffers or
+// callbacks involved.
+static volatile unsigned char *TWI_regs;
+static const unsigned char *   TWI_regWriteMask;
+static unsigned char           TWI_regSize;
+static volatile unsigned char  TWI_regPointer;
+static unsigned char           TWI_regAddrNext;
+
 /*=========================> Locals <=======================================*/
 static uint8_t *        TWI_RxBuf = TWI_Buffer;
 static volatile uint8_t TWI_RxHead;
@@ -66,7 +80,8 @@ void USI_TWI_Slave_Initialise(unsigned char TWI_ownAddress)
 {
   Flush_TWI_Buffers();
 
-  TWI_slaveAddress = TWI_ownAddress;
+  TWI_addressCompare = TWI_ownAddress << 1;
+  TWI_addressCare = 0xFE;
 
   USI_TWI_On_Slave_Transmit = 0;
   USI_TWI_On_Slave_Receive = 0;
@@ -152,6 +167,48 @@ unsigned char USI_TWI_Slave_Is_Active()
   return (USICR & (1 << USIOIE)) && ((USISR & (1 << USIPF)) == 0);
 }
 
+/*----------------------------------------------------------
+ Also answer to every address which differs from our own only
+ in the bits set in mask, e.g. address 0x20 with mask 0x03
+ answers to 0x20 to 0x23. Call after USI_TWI_Slave_Initialise.
+----------------------------------------------------------*/
+void USI_TWI_Slave_Address_Mask(unsigned char mask)
+{
+  TWI_addressCare = ~(mask << 1) & 0xFE;
+}
+
+// The address of the last transfer addressed to us (0 for a general call).
+unsigned char USI_TWI_Slave_Matched_Address(void)
+{
+  return TWI_matchedAddress;
+}
+
+/*----------------------------------------------------------
+ Serve a register map instead of the buffers and callbacks:
+ the first byte of a write sets the register pointer (out of
+ range is NACKed), following bytes are written through
+ writeMask (NULL: all bits writable), and reads stream from
+ the pointer on. The pointer increments after every byte and
+ wraps at size. Pass NULL as regs (or 0 as size) to go back
+ to buffer mode.
+----------------------------------------------------------*/
+void USI_TWI_Slave_Register_Map(volatile unsigned char *regs, unsigned char size, const unsigned char *writeMask)
+{
+  unsigned char oldSREG = SREG;
+  cli();
+  TWI_regs = size ? regs : 0; // an empty map is no map
+  TWI_regSize = size;
+  TWI_regWriteMask = writeMask;
+  TWI_regPointer = 0;
+  TWI_regAddrNext = 0;
+  SREG = oldSREG;
+}
+
+unsigned char USI_TWI_Slave_Register_Pointer(void)
+{
+  return TWI_regPointer;
+}
+
 /*----------------------------------------------------------
  Detects the USI_TWI Start Condition and initializes the USI
  for reception of the "TWI Address" packet.
@@ -199,23 +256,99 @@ __interrupt void USI_Start_Condition_ISR(void)
           (0x0 << USICNT0); // Set USI to sample 8 bits i.e. count 16 external pin toggles.
 }
 
+unsigned char USI_TWI_Master_Async_Overflow(void) __attribute__((weak));
+
+// The full overflow handler; the name has to start with __vector for gcc to
+// accept the signal attribute on it.
+void __vector_usi_twi_overflow(void) __attribute__((signal, used));
+
+/*----------------------------------------------------------
+ The vector only rejects address bytes which are not ours,
+ using two registers, so that on a busy bus the transfers to
+ other devices cost a few dozen cycles each instead of a full
+ register save. Everything else, including the interrupt
+ driven master, goes on to __vector_usi_twi_overflow.
+----------------------------------------------------------*/
+ISR(USI_OVERFLOW_VECTOR, ISR_NAKED)
+{
+  __asm__ __volatile__ (
+    "push r24"                "\n\t"
+    "in   r24, __SREG__"      "\n\t"
+    "push r24"                "\n\t"
+    "push r25"                "\n\t"
+    "lds  r24, %[usicr]"      "\n\t"
+    "sbrs r24, %[usisie]"     "\n\t" // Not in slave mode (async master)
+    "rjmp 1f"                 "\n\t"
+    "lds  r24, %[state]"      "\n\t"
+    "cpi  r24, %[check]"      "\n\t"
+    "brne 1f"                 "\n\t"
+    "lds  r24, %[usidr]"      "\n\t"
+    "tst  r24"                "\n\t" // General call
+    "breq 1f"                 "\n\t"
+    "lds  r25, %[compare]"    "\n\t"
+    "eor  r24, r25"           "\n\t"
+    "lds  r25, %[care]"       "\n\t"
+    "and  r24, r25"           "\n\t"
+    "breq 1f"                 "\n\t" // Ours
+    "cbi  %[ddr], %[sda]"     "\n\t" // Not ours, wait for the next start
+    "ldi  r24, %[startcr]"    "\n\t"
+    "sts  %[usicr], r24"      "\n\t"
+    "ldi  r24, %[startsr]"    "\n\t"
+    "sts  %[usisr], r24"      "\n\t"
+    "pop  r25"                "\n\t"
+    "pop  r24"                "\n\t"
+    "out  __SREG__, r24"      "\n\t"
+    "pop  r24"                "\n\t"
+    "reti"                    "\n"
+  "1:"                        "\n\t"
+    "pop  r25"                "\n\t"
+    "pop  r24"                "\n\t"
+    "out  __SREG__, r24"      "\n\t"
+    "pop  r24"                "\n\t"
+    "%~jmp __vector_usi_twi_overflow" "\n\t"
+    :
+    : [usicr] "n" (_SFR_MEM_ADDR(USICR)),
+      [usisr] "n" (_SFR_MEM_ADDR(USISR)),
+      [usidr] "n" (_SFR_MEM_ADDR(USIDR)),
+      [usisie] "I" (USISIE),
+      [state] "i" (&USI_TWI_Overflow_State),
+      [check] "M" (USI_SLAVE_CHECK_ADDRESS),
+      [compare] "i" (&TWI_addressCompare),
+      [care] "i" (&TWI_addressCare),
+      [ddr] "I" (_SFR_IO_ADDR(DDR_USI)),
+      [sda] "I" (PORT_USI_SDA),
+      [startcr] "M" (USI_TWI_USICR_START_CONDITION_MODE),
+      [startsr] "M" (USI_TWI_USISR_START_CONDITION_MODE)
+  );
+}
+
 /*----------------------------------------------------------
  Handles all the communication. Is disabled only when waiting
  for new Start Condition.
 ----------------------------------------------------------*/
-ISR(USI_OVERFLOW_VECTOR)
+void __vector_usi_twi_overflow(void)
 {
   unsigned char tmpRxHead;
   unsigned char tmpTxTail; // Temporary variables to store volatiles
   unsigned char tmpUSIDR;
+  unsigned char tmpPointer;
+
+  // The interrupt driven master shares this vector; it is only linked in
+  // (and only takes the interrupt) while an asynchronous transfer runs.
+  if (USI_TWI_Master_Async_Overflow && USI_TWI_Master_Async_Overflow())
+    return;
 
   switch (USI_TWI_Overflow_State) {
   // ---------- Address mode ----------
   // Check address and send ACK (and next USI_SLAVE_SEND_DATA) if OK, else reset USI.
   case USI_SLAVE_CHECK_ADDRESS:
-    if ((USIDR == 0) || ((USIDR >> 1) == TWI_slaveAddress)) {
-      if (USIDR & 0x01) {
-        if (USI_TWI_On_Slave_Transmit) {
+    tmpUSIDR = USIDR;
+    if ((tmpUSIDR == 0) || (((tmpUSIDR ^ TWI_addressCompare) & TWI_addressCare) == 0)) {
+      TWI_matchedAddress = tmpUSIDR >> 1;
+      if (tmpUSIDR & 0x01) {
+        if (TWI_regs) {
+          // register map: nothing to prepare
+        } else if (USI_TWI_On_Slave_Transmit) {
           // reset tx buffer and call callback
           tmpTxTail = TWI_TxHead;
           TWI_TxTail = tmpTxTail;
@@ -223,6 +356,7 @@ ISR(USI_OVERFLOW_VECTOR)
         }
         USI_TWI_Overflow_State = USI_SLAVE_SEND_DATA;
       } else {
+        TWI_regAddrNext = 1;
         USI_TWI_Overflow_State = USI_SLAVE_REQUEST_DATA;
       }
       SET_USI_TO_SEND_ACK();
@@ -245,6 +379,17 @@ ISR(USI_OVERFLOW_VECTOR)
   /* Falls through. */
   case USI_SLAVE_SEND_DATA:
 
+    if (TWI_regs) {
+      tmpPointer = TWI_regPointer;
+      USIDR = TWI_regs[tmpPointer];
+      if (++tmpPointer >= TWI_regSize)
+        tmpPointer = 0;
+      TWI_regPointer = tmpPointer;
+      USI_TWI_Overflow_State = USI_SLAVE_REQUEST_REPLY_FROM_SEND_DATA;
+      SET_USI_TO_SEND_DATA();
+      break;
+    }
+
     // Get data from Buffer
     tmpTxTail = TWI_TxTail; // Not necessary, but prevents warnings
     if (TWI_TxHead != tmpTxTail) {
@@ -292,6 +437,29 @@ ISR(USI_OVERFLOW_VECTOR)
     // Put data into Buffer
     USI_TWI_Overflow_State = USI_SLAVE_REQUEST_DATA;
     tmpUSIDR              = USIDR; // Not necessary, but prevents warnings
+    if (TWI_regs) {
+      if (TWI_regAddrNext) {
+        TWI_regAddrNext = 0;
+        if (tmpUSIDR >= TWI_regSize) {
+          SET_USI_TO_SEND_NACK();
+          break;
+        }
+        TWI_regPointer = tmpUSIDR;
+      } else {
+        tmpPointer = TWI_regPointer;
+        if (TWI_regWriteMask) {
+          tmpRxHead = TWI_regWriteMask[tmpPointer];
+          TWI_regs[tmpPointer] = (TWI_regs[tmpPointer] & ~tmpRxHead) | (tmpUSIDR & tmpRxHead);
+        } else {
+          TWI_regs[tmpPointer] = tmpUSIDR;
+        }
+        if (++tmpPointer >= TWI_regSize)
+          tmpPointer = 0;
+        TWI_regPointer = tmpPointer;
+      }
+      SET_USI_TO_SEND_ACK();
+      break;
+    }
     tmpRxHead = (TWI_RxHead + 1) & TWI_RX_BUFFER_MASK;
     if (TWI_RxTail != tmpRxHead) {
       TWI_RxHead            = tmpRxHead;
@@ -32,6 +32,10 @@ unsigned char USI_TWI_Peek_Receive_Byte(void);
 unsigned char USI_TWI_Data_In_Receive_Buffer(void);
 unsigned char USI_TWI_Space_In_Transmission_Buffer(void);
 unsigned char USI_TWI_Slave_Is_Active();
+void          USI_TWI_Slave_Address_Mask(unsigned char);
+unsigned char USI_TWI_Slave_Matched_Address(void);
+void          USI_TWI_Slave_Register_Map(volatile unsigned char *, unsigned char, const unsigned char *);
+unsigned char USI_TWI_Slave_Register_Pointer(void);
 
 void (*USI_TWI_On_Slave_Transmit)(void);
 void (*USI_TWI_On_Slave_Receive)(int);
@@ -104,17 +108,22 @@ extern uint8_t TWI_Buffer[];
             (0x0E << USICNT0); /* set USI counter to shift 1 bit. */                                               \
   }
 
+// USICR/USISR values while waiting for a start condition, also used by the
+// address reject path in the overflow vector.
+#define USI_TWI_USICR_START_CONDITION_MODE                                                                             \
+  ((1 << USISIE) | (0 << USIOIE) | /* Enable Start Condition Interrupt. Disable Overflow Interrupt.*/                 \
+   (1 << USIWM1) | (0 << USIWM0) | /* Set USI in Two-wire mode. No USI Counter overflow hold.      */                 \
+   (1 << USICS1) | (0 << USICS0) | (0 << USICLK) | /* Shift Register Clock Source = External, positive edge */        \
+   (0 << USITC))
+#define USI_TWI_USISR_START_CONDITION_MODE                                                                             \
+  ((0 << USI_START_COND_INT) | (1 << USIOIF) | (1 << USIPF) | (1 << USIDC) | /* Clear all flags, except Start Cond */ \
+   (0x0 << USICNT0))
+
 #define SET_USI_TO_TWI_START_CONDITION_MODE()                                                                          \
   {                                                                                                                  \
     DDR_USI &= ~(1 << PORT_USI_SDA); /* Set SDA as input */                                                       \
-    USICR = (1 << USISIE) | (0 << USIOIE) | /* Enable Start Condition Interrupt. Disable Overflow Interrupt.*/     \
-            (1 << USIWM1) | (0 << USIWM0) | /* Set USI in Two-wire mode. No USI Counter overflow hold.      */     \
-            (1 << USICS1) | (0 << USICS0) | (0 << USICLK)                                                          \
-            | /* Shift Register Clock Source = External, positive edge        */                                   \
-            (0 << USITC);                                                                                          \
-    USISR = (0 << USI_START_COND_INT) | (1 << USIOIF) | (1 << USIPF) | (1 << USIDC)                                \
-            | /* Clear all flags, except Start Cond                            */                                  \
-            (0x0 << USICNT0);                                                                                      \
+    USICR = USI_TWI_USICR_START_CONDITION_MODE;                                                                    \
+    USISR = USI_TWI_USISR_START_CONDITION_MODE;                                                                    \
   }
 
 #define SET_USI_TO_SEND_DATA()                                                                                         \
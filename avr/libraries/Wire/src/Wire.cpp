@@ -187,6 +187,28 @@ uint8_t TwoWire::endTransmission(void)
   return endTransmission(true);
 }
 
+// Streaming transfers (see Wire.h): twi.c holds the bus in TWI_MHOLD, with TWINT left set, between chunks
+uint8_t TwoWire::beginWrite(uint8_t address)
+{
+  return twi_beginWrite(address);
+}
+
+uint8_t TwoWire::writeChunk(const uint8_t *data, size_t length)
+{
+  return twi_writeChunk(data, length);
+}
+
+uint8_t TwoWire::endWrite(uint8_t sendStop)
+{
+  twi_endWrite(sendStop);
+  return 0;
+}
+
+size_t TwoWire::readInto(uint8_t address, uint8_t *buffer, size_t length, uint8_t sendStop)
+{
+  return twi_readInto(address, buffer, length, sendStop);
+}
+
 // must be called in:
 // slave tx event callback
 // or after beginTransmission(address)
@@ -381,6 +403,12 @@ void TwoWire::begin(int address) {
   begin((uint8_t)address);
 }
 
+// answer to every address which differs from address only in the bits set in mask
+void TwoWire::begin(uint8_t address, uint8_t mask) {
+  begin(address);
+  USI_TWI_Slave_Address_Mask(mask);
+}
+
 void TwoWire::end(void) {
   USI_TWI_Slave_Disable();
   DDR_USI_CL &= ~(1 << PIN_USI_SCL); // Enable SCL as input.
@@ -390,7 +418,13 @@ void TwoWire::end(void) {
 }
 
 void TwoWire::setClock(uint32_t clock) {
-  USI_TWI_Master_Speed(clock>200000);
+  if (clock > 600000) {
+    USI_TWI_Master_Speed(USI_TWI_FAST_MODE_PLUS);
+  } else if (clock > 200000) {
+    USI_TWI_Master_Speed(USI_TWI_FAST_MODE);
+  } else {
+    USI_TWI_Master_Speed(USI_TWI_STANDARD_MODE);
+  }
 }
 
 uint8_t TwoWire::requestFrom(uint8_t address, uint8_t quantity,
@@ -483,23 +517,78 @@ uint8_t TwoWire::endTransmission(uint8_t sendStop) {
   transmitting = 0;
   // check for error
   if (ret == FALSE) {
-    switch (USI_TWI_Get_State_Info()) {
-    case USI_TWI_DATA_OUT_OF_BOUND:
-      return 1; //data too long to fit in transmit buffer
-    case USI_TWI_NO_ACK_ON_ADDRESS:
-      return 2; //received NACK on transmit of address
-    case USI_TWI_NO_ACK_ON_DATA:
-      return 3; //received NACK on transmit of data
-    }
-    return 4; //other error
+    return statusCode(USI_TWI_Get_State_Info());
   }
   return 0; //success
 }
 
+// Maps a USI_TWI_Master error to what endTransmission() returns
+uint8_t TwoWire::statusCode(uint8_t state) {
+  switch (state) {
+  case 0:
+    return 0; //success, as the asynchronous transfers report it
+  case USI_TWI_DATA_OUT_OF_BOUND:
+    return 1; //data too long to fit in transmit buffer
+  case USI_TWI_NO_ACK_ON_ADDRESS:
+    return 2; //received NACK on transmit of address
+  case USI_TWI_NO_ACK_ON_DATA:
+    return 3; //received NACK on transmit of data
+  }
+  return 4; //other error
+}
+
 uint8_t TwoWire::endTransmission(void) {
   return endTransmission(true);
 }
 
+// Streaming transfers (see Wire.h): the USI holds SCL low between chunks
+uint8_t TwoWire::beginWrite(uint8_t address) {
+  if (!USI_TWI_Master_Start()) {
+    return 4;
+  }
+  if (!USI_TWI_Master_Write_Byte((address << TWI_ADR_BITS) | (0 << TWI_READ_BIT))) {
+    USI_TWI_Master_Stop();
+    return 2; //received NACK on transmit of address
+  }
+  return 0;
+}
+
+uint8_t TwoWire::writeChunk(const uint8_t *data, size_t length) {
+  while (length--) {
+    if (!USI_TWI_Master_Write_Byte(*data++)) {
+      USI_TWI_Master_Stop();
+      return 3; //received NACK on transmit of data
+    }
+  }
+  return 0;
+}
+
+uint8_t TwoWire::endWrite(uint8_t sendStop) {
+  // for a repeated start there is nothing to do, the next start begins by
+  // releasing SCL
+  if (sendStop) {
+    USI_TWI_Master_Stop();
+  }
+  return 0;
+}
+
+size_t TwoWire::readInto(uint8_t address, uint8_t *buffer, size_t length, uint8_t sendStop) {
+  if (length == 0 || !USI_TWI_Master_Start()) {
+    return 0;
+  }
+  if (!USI_TWI_Master_Write_Byte((address << TWI_ADR_BITS) | (1 << TWI_READ_BIT))) {
+    USI_TWI_Master_Stop();
+    return 0;
+  }
+  for (size_t left = length; left; left--) {
+    *buffer++ = USI_TWI_Master_Read_Byte(left == 1); // NACK the last byte
+  }
+  if (sendStop) {
+    USI_TWI_Master_Stop();
+  }
+  return length;
+}
+
 // must be called in:
 // slave tx event callback
 // or after beginTransmission(address)
@@ -610,6 +699,16 @@ uint8_t TwoWire::isActive(void) {
   return USI_TWI_Slave_Is_Active();
 }
 
+// slave address of the last transfer addressed to us (0 for a general call)
+uint8_t TwoWire::matchedAddress(void) {
+  return USI_TWI_Slave_Matched_Address();
+}
+
+// slave register map mode, see USI_TWI_Slave.c
+void TwoWire::registerMap(volatile uint8_t *regs, uint8_t size, const uint8_t *writeMask) {
+  USI_TWI_Slave_Register_Map(regs, size, writeMask);
+}
+
 // Preinstantiate Objects //////////////////////////////////////////////////////s
 TwoWire Wire = TwoWire();
 #else
@@ -741,6 +840,33 @@ uint8_t TwoWire::endTransmission(void) {
   return endTransmission(true);
 }
 
+// Streaming transfers (see Wire.h): bit-banged by SoftWire, which has no buffer to bypass
+uint8_t TwoWire::beginWrite(uint8_t address) {
+  #ifndef WIRE_MASTER_ONLY
+  if (slaveMode) {
+    return 4; //other error
+  }
+  #endif
+  return softWire.beginWrite(address);
+}
+
+uint8_t TwoWire::writeChunk(const uint8_t *data, size_t length) {
+  return softWire.writeChunk(data, length);
+}
+
+uint8_t TwoWire::endWrite(uint8_t sendStop) {
+  return softWire.endTransmission(sendStop);
+}
+
+size_t TwoWire::readInto(uint8_t address, uint8_t *buffer, size_t length, uint8_t sendStop) {
+  #ifndef WIRE_MASTER_ONLY
+  if (slaveMode) {
+    return 0;
+  }
+  #endif
+  return softWire.readInto(address, buffer, length, sendStop);
+}
+
 #endif //stuff that's not there in slave only
 
 // must be called in:
@@ -937,6 +1063,11 @@ void TwoWire::onReceive( void (*function)(int) ) {
 void TwoWire::onRequest(void(*function)(void)) {
   TinyWireS.onRequest(function);
 }
+
+// slave register map mode, see WireS.h
+void TwoWire::registerMap(volatile uint8_t *regs, uint8_t size, const uint8_t *writeMask) {
+  TinyWireS.registerMap(regs, size, writeMask);
+}
 #endif
 
 // Preinstantiate Objects //////////////////////////////////////////////////////
@@ -36,6 +36,14 @@
 
   Regardless of which implementation is used, the class is called TwoWire,
   and the library provides an instance of it named Wire
+
+  Streaming master transfers, on all three: beginWrite() addresses the slave
+  and keeps the bus, each writeChunk() sends straight from the caller's
+  buffer (no BUFFER_LENGTH limit, no copy), and endWrite() sends the stop -
+  or with false, leaves a repeated start for the next beginWrite() or
+  readInto(). readInto() reads straight into the caller's buffer. They
+  return the same codes as endTransmission(), except readInto(), which
+  returns the number of bytes read. A NACK releases the bus.
 */
 
 #include <avr/io.h>
@@ -85,6 +93,10 @@ class TwoWire : public Stream
     uint8_t requestFrom(uint8_t, uint8_t, uint32_t, uint8_t, uint8_t);
     uint8_t requestFrom(int, int);
     uint8_t requestFrom(int, int, int);
+    uint8_t beginWrite(uint8_t);
+    uint8_t writeChunk(const uint8_t *, size_t);
+    uint8_t endWrite(uint8_t sendStop = true);
+    size_t readInto(uint8_t, uint8_t *, size_t, uint8_t sendStop = true);
     virtual size_t write(uint8_t);
     virtual size_t write(const uint8_t *, size_t);
     virtual int available(void);
@@ -124,11 +136,17 @@ class TwoWire {
     static uint8_t BufferLength;
     static uint8_t fastmode;
     static uint8_t transmitting;
+    static uint8_t asyncQuantity;
+    static void (*asyncCallback)(uint8_t);
+    static uint8_t statusCode(uint8_t);
+    static void onAsyncWriteDone(uint8_t);
+    static void onAsyncReadDone(uint8_t);
   public:
     TwoWire();
     void begin();
     void begin(uint8_t);
     void begin(int);
+    void begin(uint8_t, uint8_t);
     void end();
     void setClock(uint32_t);
     void beginTransmission(uint8_t);
@@ -140,6 +158,10 @@ class TwoWire {
     uint8_t requestFrom(uint8_t, uint8_t, uint32_t, uint8_t, uint8_t);
     uint8_t requestFrom(int, int);
     uint8_t requestFrom(int, int, int);
+    uint8_t beginWrite(uint8_t);
+    uint8_t writeChunk(const uint8_t *, size_t);
+    uint8_t endWrite(uint8_t sendStop = true);
+    size_t readInto(uint8_t, uint8_t *, size_t, uint8_t sendStop = true);
     size_t write(uint8_t);
     size_t write(const uint8_t *, size_t);
     size_t write(const char *);
@@ -150,6 +172,12 @@ class TwoWire {
     void onReceive( void (*)(int) );
     void onRequest( void (*)(void) );
     uint8_t isActive(void);
+    uint8_t matchedAddress(void);
+    void registerMap(volatile uint8_t *, uint8_t, const uint8_t *writeMask = NULL);
+    // Interrupt driven master transfers, see WireAsync.cpp
+    uint8_t endTransmissionAsync(void (*)(uint8_t), uint8_t sendStop = true);
+    uint8_t requestFromAsync(uint8_t, uint8_t, void (*)(uint8_t), uint8_t sendStop = true);
+    uint8_t isBusy(void);
 
     inline size_t write(unsigned long n) { return write((uint8_t)n); }
     inline size_t write(long n) { return write((uint8_t)n); }
@@ -187,6 +215,10 @@ public:
   uint8_t requestFrom(uint8_t, uint8_t, uint32_t, uint8_t, uint8_t);
   uint8_t requestFrom(int, int);
   uint8_t requestFrom(int, int, int);
+  uint8_t beginWrite(uint8_t);
+  uint8_t writeChunk(const uint8_t *, size_t);
+  uint8_t endWrite(uint8_t sendStop = true);
+  size_t readInto(uint8_t, uint8_t *, size_t, uint8_t sendStop = true);
   size_t write(uint8_t);
   size_t write(const uint8_t *, size_t);
   size_t write(const char *);
@@ -197,6 +229,7 @@ public:
   void onReceive(void(*)(int));
   void onReceive( void (*)(size_t) );
   void onRequest(void(*)(void));
+  void registerMap(volatile uint8_t *, uint8_t, const uint8_t *writeMask = NULL);
 
   inline size_t write(unsigned long n) { return write((uint8_t)n); }
   inline size_t write(long n) { return write((uint8_t)n); }
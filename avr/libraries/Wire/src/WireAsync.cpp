@@ -0,0 +1,105 @@
+/*
+  WireAsync.cpp - interrupt driven master transfers for the USI Wire
+  Part of ATTinyCore
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+  Kept apart from Wire.cpp so that USI_TWI_Master_Async.c, and the Timer1
+  interrupt it brings with it, is only linked into sketches which call these.
+*/
+
+#include <avr/io.h>
+#if !defined(TWDR) && defined(USIDR)
+extern "C" {
+#include <inttypes.h>
+#include "USI_TWI_Slave/USI_TWI_Slave.h"
+#include "USI_TWI_Master/USI_TWI_Master.h"
+}
+
+#include "Wire.h"
+
+uint8_t TwoWire::asyncQuantity = 0;
+void (*TwoWire::asyncCallback)(uint8_t) = 0;
+
+// Both of these run in the USI overflow interrupt, and so does the callback
+
+void TwoWire::onAsyncWriteDone(uint8_t state) {
+  // reset tx buffer iterator vars
+  BufferIndex = 0;
+  BufferLength = 0;
+  // indicate that we are done transmitting
+  transmitting = 0;
+  if (asyncCallback) {
+    asyncCallback(statusCode(state));
+  }
+}
+
+void TwoWire::onAsyncReadDone(uint8_t state) {
+  // set rx buffer iterator vars, the slave address is not data
+  BufferIndex = 1;
+  BufferLength = state ? BufferIndex : asyncQuantity;
+  if (asyncCallback) {
+    asyncCallback(BufferLength - BufferIndex);
+  }
+}
+
+// Sends what was written since beginTransmission() and returns at once.
+// callback gets what endTransmission() would have returned.  Returns 0 if the
+// transfer started, or 4 if it could not (another one is still running, or
+// the bus is not free).
+uint8_t TwoWire::endTransmissionAsync(void (*callback)(uint8_t), uint8_t sendStop) {
+  if (USI_TWI_Master_Async_Busy()) {
+    return 4;
+  }
+  asyncCallback = callback;
+  if (USI_TWI_Start_Transceiver_Async(Buffer, BufferLength, sendStop, onAsyncWriteDone)) {
+    return 4;
+  }
+  return 0;
+}
+
+// Like requestFrom(), but returns at once, and callback gets the number of
+// bytes read (0 for an error) when they can be read().  Returns 0 if the
+// transfer started, 4 if it could not.
+uint8_t TwoWire::requestFromAsync(uint8_t address, uint8_t quantity,
+                                  void (*callback)(uint8_t), uint8_t sendStop) {
+  // reserve one byte for slave address
+  quantity++;
+  // clamp to buffer length
+  if (quantity > TWI_BUFFER_SIZE) {
+    quantity = TWI_BUFFER_SIZE;
+  }
+  if (USI_TWI_Master_Async_Busy()) {
+    return 4;
+  }
+  // set address of targeted slave and read mode
+  Buffer[0] = (address << TWI_ADR_BITS) | (1 << TWI_READ_BIT);
+  // nothing to read until it is done
+  BufferIndex = 1;
+  BufferLength = BufferIndex;
+  asyncQuantity = quantity;
+  asyncCallback = callback;
+  if (USI_TWI_Start_Transceiver_Async(Buffer, quantity, sendStop, onAsyncReadDone)) {
+    return 4;
+  }
+  return 0;
+}
+
+// True while an asynchronous transfer is running; nothing else may be done
+// with Wire (or its buffer) until it is over.
+uint8_t TwoWire::isBusy(void) {
+  return USI_TWI_Master_Async_Busy();
+}
+#endif
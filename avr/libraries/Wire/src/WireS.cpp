@@ -80,6 +80,17 @@ size_t i2c_tinyS::write(const uint8_t* data, size_t quantity) {
     }
 }
 
+void i2c_tinyS::registerMap_(struct i2cStruct* i2c, volatile uint8_t* regs, uint8_t size, const uint8_t* writeMask) {
+    uint8_t oldSREG = SREG;
+    cli();
+    i2c->regs = size ? regs : NULL;
+    i2c->regSize = size;
+    i2c->regWriteMask = writeMask;
+    i2c->regPointer = 0;
+    i2c->regAddrNext = 0;
+    SREG = oldSREG;
+}
+
 int i2c_tinyS::read_(struct i2cStruct* i2c) {
     if(i2c->rxBufferIndex >= i2c->rxBufferLength) return -1;
     return i2c->Buffer[i2c->rxBufferIndex++];
@@ -128,13 +139,18 @@ void i2c_isr_handler() {
                     return;
                 }
             }
-            if ((status & _BV(TWDIR))) {
+            if (i2c->regs) {
+                // a write starts with the register number
+                i2c->regAddrNext = !(status & _BV(TWDIR));
+            } else if ((status & _BV(TWDIR))) {
                 i2c->txBufferLength = 0;
                 if (i2c->user_onRequest != (void *)NULL) i2c->user_onRequest();
                 i2c->txBufferIndex = 0;
             } else i2c->rxBufferLength = 0;
         } else {
-            if ((status & _BV(TWDIR))) {
+            if (i2c->regs) {
+                // nothing to hand over, the data is already in place
+            } else if ((status & _BV(TWDIR))) {
                 if (i2c->user_onStop != (void *)NULL) i2c->user_onStop();
             } else {
                 if (i2c->user_onReceive != (void *)NULL) {
@@ -148,7 +164,34 @@ void i2c_isr_handler() {
             return;
         }
     } else if ((status & _BV(TWDIF))) {
-        if ((status & _BV(TWDIR))) {
+        volatile uint8_t* regs = i2c->regs;
+        if (regs) {
+            uint8_t ptr = i2c->regPointer;
+            if ((status & _BV(TWDIR))) {
+                TWSD = regs[ptr];
+            } else {
+                uint8_t data = TWSD;
+                if (i2c->regAddrNext) {
+                    i2c->regAddrNext = 0;
+                    if (data >= i2c->regSize) {
+                        TWSCRB = (B0110 | TWI_HIGH_NOISE_MODE); // no such register, NACK
+                        return;
+                    }
+                    i2c->regPointer = data;
+                    TWSCRB = (B0011 | TWI_HIGH_NOISE_MODE);
+                    return;
+                }
+                const uint8_t* mask = i2c->regWriteMask;
+                if (mask) {
+                    uint8_t m = mask[ptr];
+                    data = (regs[ptr] & ~m) | (data & m);
+                }
+                regs[ptr] = data;
+            }
+            // auto increment, wrapping around at the end of the map
+            if (++ptr >= i2c->regSize) ptr = 0;
+            i2c->regPointer = ptr;
+        } else if ((status & _BV(TWDIR))) {
             if (i2c->txBufferIndex < i2c->txBufferLength) TWSD = i2c->Buffer[i2c->txBufferIndex++];
             else {
                 TWSCRB = (B0010 | TWI_HIGH_NOISE_MODE);
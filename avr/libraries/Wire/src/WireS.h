@@ -72,6 +72,11 @@ struct i2cStruct {
     void (*user_onReceive)(size_t);          // Slave Rx Callback Function        (User)
     void (*user_onRequest)(void);            // Slave Tx Callback Function        (User)
     void (*user_onStop)(void);               // Stop Callback Function            (User)
+    volatile uint8_t* regs;                  // Register map, NULL if not used    (User)
+    const uint8_t* regWriteMask;             // Writable bits of each register    (User)
+    uint8_t  regSize;                        // Registers in the map              (User)
+    volatile uint8_t regPointer;             // Next register to read or write    (User&ISR)
+    volatile uint8_t regAddrNext;            // Next byte written is the pointer  (ISR)
 };
 
 extern "C" void i2c_isr_handler(struct i2cStruct* i2c);
@@ -114,6 +119,16 @@ class i2c_tinyS : public Stream {
         inline void onReceive(void (*function)(size_t)) { i2c->user_onReceive = function; }
         inline void onRequest(void (*function)(void)) { i2c->user_onRequest = function; }
         inline void onStop(void (*function)(void)) { i2c->user_onStop = function; }
+        // Register map mode: the master writes a register number and then
+        // data, or reads from the last register number on. The ISR works
+        // on regs directly, with no buffer and no callbacks; writeMask, if
+        // given, has a byte for each register with the bits which the
+        // master may change. A NULL regs goes back to the buffered mode.
+        static void registerMap_(struct i2cStruct* i2c, volatile uint8_t* regs, uint8_t size, const uint8_t* writeMask);
+        inline void registerMap(volatile uint8_t* regs, uint8_t size, const uint8_t* writeMask = NULL) {
+            registerMap_(i2c, regs, size, writeMask);
+        }
+        inline uint8_t registerPointer(void) { return i2c->regPointer; }
 };
 
 extern i2c_tinyS TinyWireS;
@@ -44,13 +44,16 @@ static volatile uint8_t twi_state;
 static volatile uint8_t twi_slarw;
 static volatile uint8_t twi_sendStop;     // should the transaction end with a stop
 static volatile uint8_t twi_inRepStart;     // in the middle of a repeated start
+static volatile uint8_t twi_hold;           // keep the bus when the data runs out, see twi_beginWrite()
 
 static void (*twi_onSlaveTransmit)(void);
 static void (*twi_onSlaveReceive)(uint8_t*, int);
 
+// The master sends from or receives into twi_masterData, which is either
+// twi_masterBuffer or, for the streaming functions, the caller's buffer.
 static uint8_t twi_masterBuffer[TWI_BUFFER_LENGTH];
-static volatile uint8_t twi_masterBufferIndex;
-static volatile uint8_t twi_masterBufferLength;
+static uint8_t * volatile twi_masterData;
+static volatile size_t twi_masterLeft;
 
 static uint8_t twi_txBuffer[TWI_BUFFER_LENGTH];
 static volatile uint8_t twi_txBufferIndex;
@@ -61,6 +64,9 @@ static volatile uint8_t twi_rxBufferIndex;
 
 static volatile uint8_t twi_error;
 
+static void twi_start(uint8_t);
+static uint8_t twi_result(void);
+
 /*
  * Function twi_init
  * Desc     readys twi pins and sets twi bitrate
@@ -142,12 +148,32 @@ void twi_setFrequency(uint32_t frequency)
  */
 uint8_t twi_readFrom(uint8_t address, uint8_t* data, uint8_t length, uint8_t sendStop)
 {
-  uint8_t i;
-
   // ensure data will fit into buffer
   if(TWI_BUFFER_LENGTH < length){
     return 0;
   }
+  return twi_readInto(address, data, length, sendStop);
+}
+
+/*
+ * Function twi_readInto
+ * Desc     attempts to become twi bus master and read a series of bytes
+ *          from a device on the bus straight into the caller's array, which
+ *          may be any size. Ends a twi_beginWrite() with a repeated start.
+ * Input    address: 7bit i2c device address
+ *          data: pointer to byte array
+ *          length: number of bytes to read into array
+ *          sendStop: Boolean indicating whether to send a stop at the end
+ * Output   number of bytes read
+ */
+size_t twi_readInto(uint8_t address, uint8_t* data, size_t length, uint8_t sendStop)
+{
+  if(0 == length){
+    return 0;
+  }
+
+  // still holding the bus after twi_beginWrite(), go on with a repeated start
+  twi_endWrite(false);
 
   // wait until twi is ready, become master receiver
   while(TWI_READY != twi_state){
@@ -155,53 +181,23 @@ uint8_t twi_readFrom(uint8_t address, uint8_t* data, uint8_t length, uint8_t sen
   }
   twi_state = TWI_MRX;
   twi_sendStop = sendStop;
+  twi_hold = false;
   // reset error state (0xFF.. no error occurred)
   twi_error = 0xFF;
 
   // initialize buffer iteration vars
-  twi_masterBufferIndex = 0;
-  twi_masterBufferLength = length-1;  // This is not intuitive, read on...
-  // On receive, the previously configured ACK/NACK setting is transmitted in
-  // response to the received byte before the interrupt is signalled.
-  // Therefore we must actually set NACK when the _next_ to last byte is
-  // received, causing that NACK to be sent in response to receiving the last
-  // expected byte of data.
-
-  // build sla+w, slave device address + w bit
-  twi_slarw = TW_READ;
-  twi_slarw |= address << 1;
+  twi_masterData = data;
+  twi_masterLeft = length;
 
-  if (true == twi_inRepStart) {
-    // if we're in the repeated start state, then we've already sent the start,
-    // (@@@ we hope), and the TWI statemachine is just waiting for the address byte.
-    // We need to remove ourselves from the repeated start state before we enable interrupts,
-    // since the ISR is ASYNC, and we could get confused if we hit the ISR before cleaning
-    // up. Also, don't enable the START interrupt. There may be one pending from the
-    // repeated start that we sent ourselves, and that would really confuse things.
-    twi_inRepStart = false;     // remember, we're dealing with an ASYNC ISR
-    do {
-      TWDR = twi_slarw;
-    } while(TWCR & _BV(TWWC));
-    TWCR = _BV(TWINT) | _BV(TWEA) | _BV(TWEN) | _BV(TWIE);  // enable INTs, but not START
-  }
-  else
-    // send start condition
-    TWCR = _BV(TWEN) | _BV(TWIE) | _BV(TWEA) | _BV(TWINT) | _BV(TWSTA);
+  // build sla+r, slave device address + r bit
+  twi_start(TW_READ | (address << 1));
 
   // wait for read operation to complete
   while(TWI_MRX == twi_state){
     continue;
   }
 
-  if (twi_masterBufferIndex < length)
-    length = twi_masterBufferIndex;
-
-  // copy twi buffer to data
-  for(i = 0; i < length; ++i){
-    data[i] = twi_masterBuffer[i];
-  }
-
-  return length;
+  return length - twi_masterLeft;
 }
 
 /*
@@ -237,9 +233,11 @@ uint8_t twi_writeTo(uint8_t address, uint8_t* data, uint8_t length, uint8_t wait
   // reset error state (0xFF.. no error occurred)
   twi_error = 0xFF;
 
+  twi_hold = false;
+
   // initialize buffer iteration vars
-  twi_masterBufferIndex = 0;
-  twi_masterBufferLength = length;
+  twi_masterData = twi_masterBuffer;
+  twi_masterLeft = length;
 
   // copy data to twi buffer
   for(i = 0; i < length; ++i){
@@ -247,8 +245,107 @@ uint8_t twi_writeTo(uint8_t address, uint8_t* data, uint8_t length, uint8_t wait
   }
 
   // build sla+w, slave device address + w bit
-  twi_slarw = TW_WRITE;
-  twi_slarw |= address << 1;
+  twi_start(TW_WRITE | (address << 1));
+
+  // wait for write operation to complete
+  while(wait && (TWI_MTX == twi_state)){
+    continue;
+  }
+
+  return twi_result();
+}
+
+/*
+ * Function twi_beginWrite
+ * Desc     attempts to become twi bus master and address a device for
+ *          writing, then keeps the bus (SCL held low) for twi_writeChunk().
+ *          If the last one was not ended yet, a repeated start ends it.
+ * Input    address: 7bit i2c device address
+ * Output   0 .. success
+ *          2 .. address send, NACK received
+ *          4 .. other twi error (lost bus arbitration, bus error, ..)
+ */
+uint8_t twi_beginWrite(uint8_t address)
+{
+  twi_endWrite(false);
+
+  // wait until twi is ready, become master transmitter
+  while(TWI_READY != twi_state){
+    continue;
+  }
+  twi_state = TWI_MTX;
+  twi_sendStop = true;
+  twi_hold = true;
+  twi_error = 0xFF;
+  twi_masterLeft = 0;
+
+  twi_start(TW_WRITE | (address << 1));
+
+  while(TWI_MTX == twi_state){
+    continue;
+  }
+  return twi_result();
+}
+
+/*
+ * Function twi_writeChunk
+ * Desc     sends bytes straight from the caller's array, after
+ *          twi_beginWrite(), and keeps the bus again afterwards
+ * Input    data: pointer to byte array
+ *          length: number of bytes in array
+ * Output   0 .. success
+ *          3 .. data send, NACK received
+ *          4 .. other twi error, or no twi_beginWrite()
+ */
+uint8_t twi_writeChunk(const uint8_t* data, size_t length)
+{
+  if(TWI_MHOLD != twi_state){
+    return 4;
+  }
+  twi_masterData = (uint8_t *)data;
+  twi_masterLeft = length;
+  twi_state = TWI_MTX;
+  // TWINT is still set from the last ACK, so turning the interrupt back on
+  // carries on from there
+  TWCR = _BV(TWEN) | _BV(TWIE) | _BV(TWEA);
+
+  while(TWI_MTX == twi_state){
+    continue;
+  }
+  return twi_result();
+}
+
+/*
+ * Function twi_endWrite
+ * Desc     ends a twi_beginWrite(), with a stop or with a repeated start
+ *          for the next transfer
+ * Input    sendStop: boolean indicating whether or not to send a stop
+ * Output   none
+ */
+void twi_endWrite(uint8_t sendStop)
+{
+  if(TWI_MHOLD != twi_state){
+    return;
+  }
+  if (sendStop) {
+    twi_stop();
+  } else {
+    twi_inRepStart = true;
+    TWCR = _BV(TWINT) | _BV(TWSTA)| _BV(TWEN) ;
+    twi_state = TWI_READY;
+  }
+}
+
+/*
+ * Function twi_start
+ * Desc     sends the start condition (unless the last transfer ended with
+ *          one already) and has the ISR send sla+r/w after it
+ * Input    slarw: slave address and r/w bit
+ * Output   none
+ */
+static void twi_start(uint8_t slarw)
+{
+  twi_slarw = slarw;
 
   // if we're in a repeated start, then we've already sent the START
   // in the ISR. Don't do it again.
@@ -269,12 +366,18 @@ uint8_t twi_writeTo(uint8_t address, uint8_t* data, uint8_t length, uint8_t wait
   else
     // send start condition
     TWCR = _BV(TWINT) | _BV(TWEA) | _BV(TWEN) | _BV(TWIE) | _BV(TWSTA); // enable INTs
+}
 
-  // wait for write operation to complete
-  while(wait && (TWI_MTX == twi_state)){
-    continue;
-  }
-
+/*
+ * Function twi_result
+ * Desc     what the last master transmit came to
+ * Output   0 .. success
+ *          2 .. address send, NACK received
+ *          3 .. data send, NACK received
+ *          4 .. other twi error (lost bus arbitration, bus error, ..)
+ */
+static uint8_t twi_result(void)
+{
   if (twi_error == 0xFF)
     return 0; // success
   else if (twi_error == TW_MT_SLA_NACK)
@@ -407,10 +510,16 @@ ISR(TWI_vect)
     case TW_MT_SLA_ACK:  // slave receiver acked address
     case TW_MT_DATA_ACK: // slave receiver acked data
       // if there is data to send, send it, otherwise stop
-      if(twi_masterBufferIndex < twi_masterBufferLength){
+      if(twi_masterLeft){
         // copy data to output register and ack
-        TWDR = twi_masterBuffer[twi_masterBufferIndex++];
+        TWDR = *twi_masterData++;
+        twi_masterLeft--;
         twi_reply(1);
+      }else if(twi_hold){
+        // wait for twi_writeChunk(): leaving TWINT set holds SCL low, so
+        // just stop the interrupt from coming straight back
+        TWCR = _BV(TWEN) | _BV(TWEA);
+        twi_state = TWI_MHOLD;
       }else{
   if (twi_sendStop)
           twi_stop();
@@ -440,10 +549,12 @@ ISR(TWI_vect)
     // Master Receiver
     case TW_MR_DATA_ACK: // data received, ack sent
       // put byte into buffer
-      twi_masterBuffer[twi_masterBufferIndex++] = TWDR;
+      *twi_masterData++ = TWDR;
+      twi_masterLeft--;
     case TW_MR_SLA_ACK:  // address sent, ack received
-      // ack if more bytes are expected, otherwise nack
-      if(twi_masterBufferIndex < twi_masterBufferLength){
+      // ack if more bytes are expected, otherwise nack. The ACK/NACK goes
+      // out in response to the byte after this one, hence the last but one.
+      if(twi_masterLeft > 1){
         twi_reply(1);
       }else{
         twi_reply(0);
@@ -451,7 +562,8 @@ ISR(TWI_vect)
       break;
     case TW_MR_DATA_NACK: // data received, nack sent
       // put final byte into buffer
-      twi_masterBuffer[twi_masterBufferIndex++] = TWDR;
+      *twi_masterData++ = TWDR;
+      twi_masterLeft--;
   if (twi_sendStop)
           twi_stop();
   else {
@@ -21,6 +21,7 @@
 #define twi_h
 
   #include <inttypes.h>
+  #include <stddef.h>
 
   //#define ATMEGA8
 
@@ -37,6 +38,7 @@
   #define TWI_MTX   2
   #define TWI_SRX   3
   #define TWI_STX   4
+  #define TWI_MHOLD 5 // master transmitter, bus held between twi_writeChunk()s
 
   void twi_init(void);
   void twi_disable(void);
@@ -44,6 +46,10 @@
   void twi_setFrequency(uint32_t);
   uint8_t twi_readFrom(uint8_t, uint8_t*, uint8_t, uint8_t);
   uint8_t twi_writeTo(uint8_t, uint8_t*, uint8_t, uint8_t, uint8_t);
+  size_t twi_readInto(uint8_t, uint8_t*, size_t, uint8_t);
+  uint8_t twi_beginWrite(uint8_t);
+  uint8_t twi_writeChunk(const uint8_t*, size_t);
+  void twi_endWrite(uint8_t);
   uint8_t twi_transmit(const uint8_t*, uint8_t);
   void twi_attachSlaveRxEvent( void (*)(uint8_t*, int) );
   void twi_attachSlaveTxEvent( void (*)(void) );
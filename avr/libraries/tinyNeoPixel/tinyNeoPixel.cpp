@@ -35,7 +35,8 @@
 
 // Constructor when length, pin and type are known at compile-time:
 tinyNeoPixel::tinyNeoPixel(uint16_t n, uint8_t p, neoPixelType t) :
-  begun(false), brightness(0), pixels(NULL), endTime(0)
+  begun(false), brightness(0), pixels(NULL), interruptInterval(0),
+  blockedMicros(0), showBrightness(0), brightnessOnShow(false), endTime(0)
 {
   updateType(t);
   updateLength(n);
@@ -49,7 +50,8 @@ tinyNeoPixel::tinyNeoPixel(uint16_t n, uint8_t p, neoPixelType t) :
 // updateLength(), etc. to establish the strand type, length and pin number!
 tinyNeoPixel::tinyNeoPixel() :
   begun(false), numLEDs(0), numBytes(0), pin(-1), brightness(0), pixels(NULL),
-  rOffset(1), gOffset(0), bOffset(2), wOffset(1), endTime(0)
+  rOffset(1), gOffset(0), bOffset(2), wOffset(1), interruptInterval(0),
+  blockedMicros(0), showBrightness(0), brightnessOnShow(false), endTime(0)
 {
 }
 
@@ -95,6 +97,35 @@ void tinyNeoPixel::updateType(neoPixelType t) {
   }
 }
 
+// (v * s) >> 8 by shifting and adding, in a fixed 33 cycles. None of these
+// parts has a hardware multiply, and the libgcc one takes several times as
+// long, which matters when it runs between pixels with the data line idle.
+#define NEO_SCALE_STEP(bit) \
+  "clc               \n\t" \
+  "sbrc %[s], " #bit "   \n\t" \
+  "add  %[r], %[v]   \n\t" \
+  "ror  %[r]         \n\t"
+
+static inline uint8_t scaleByte(uint8_t v, uint8_t s) __attribute__((always_inline));
+static inline uint8_t scaleByte(uint8_t v, uint8_t s) {
+  uint8_t r;
+  __asm__ (
+    "clr  %[r]         \n\t"
+    NEO_SCALE_STEP(0) NEO_SCALE_STEP(1) NEO_SCALE_STEP(2) NEO_SCALE_STEP(3)
+    NEO_SCALE_STEP(4) NEO_SCALE_STEP(5) NEO_SCALE_STEP(6) NEO_SCALE_STEP(7)
+    : [r] "=&r" (r)
+    : [v] "r" (v), [s] "r" (s)
+  );
+  return r;
+}
+
+// Only the 800 kHz bitstream is supported (there is no NEO_KHZ400 here), so
+// each byte is 8 bits of 1.25 us. Saturates rather than wrapping on long strips.
+static uint16_t bytesToMicros(uint32_t count) {
+  count *= 10;
+  return (count > 0xFFFF) ? 0xFFFF : count;
+}
+
 void tinyNeoPixel::show(void) {
 
   if(!pixels) return;
@@ -121,13 +152,32 @@ void tinyNeoPixel::show(void) {
   // to the PORT register as needed.
 
   noInterrupts(); // Need 100% focus on instruction timing
+  if(brightnessOnShow && showBrightness) {
+    sendScaled();
+  } else if(interruptInterval) {
+    sendChunked(pixels, numBytes);
+  } else {
+    blockedMicros = bytesToMicros(numBytes);
+    sendBytes(pixels, numBytes);
+  }
+  interrupts();
+  #ifndef DISABLEMILLIS
+  endTime = micros(); // Save EOD time for latch on next call
+  #endif
+}
+
+// Issue count bytes starting at data to the LEDs; interrupts must already
+// be off. Never inlined or cloned, as the asm labels may only appear once.
+void tinyNeoPixel::sendBytes(uint8_t *data, uint16_t count) {
+
+  if(!count) return;
 
 // AVR MCUs --  ATtiny and megaAVR ATtiny -------------------------------
 
   volatile uint16_t
-    i   = numBytes; // Loop counter
+    i   = count;    // Loop counter
   volatile uint8_t
-   *ptr = pixels,   // Pointer to next byte
+   *ptr = data,     // Pointer to next byte
     b   = *ptr++,   // Current byte value
     hi,             // PORT w/output bit set high
     lo;             // PORT w/output bit set low
@@ -556,11 +606,113 @@ void tinyNeoPixel::show(void) {
 
 
 // END AVR ----------------------------------------------------------------
+}
+
+// Interrupt tolerant output: after every interruptInterval pixels, with the
+// data line low, interrupts are enabled for an instruction so that anything
+// pending (the millis timer, serial receive) runs. Only one interrupt gets in
+// each time: the AVR runs one instruction after a reti before taking the next,
+// and that is the cli. The LEDs only latch when the line stays low for their
+// reset time (50 us or more on WS2812B and SK6812), so every interrupt that
+// can fire has to finish well within that.
+void tinyNeoPixel::sendChunked(uint8_t *data, uint16_t count) {
+  uint16_t chunk = interruptInterval * ((wOffset == rOffset) ? 3 : 4);
+  blockedMicros = bytesToMicros(count < chunk ? count : chunk);
+  while(count) {
+    uint16_t n = (count < chunk) ? count : chunk;
+    sendBytes(data, n);
+    data  += n;
+    count -= n;
+    interrupts();
+    __asm__ __volatile__("nop");
+    noInterrupts();
+  }
+}
 
+// Pixels to send between interrupt windows, 0 (the default) for none.
+void tinyNeoPixel::setInterruptInterval(uint8_t pixels) {
+  interruptInterval = pixels;
+}
+
+// The longest stretch the last show() kept interrupts off for, worked out
+// from the number of bytes. Timer overflows which fall in a stretch longer
+// than their period are lost to millis(); nothing here puts them back, that
+// is left to the sketch.
+uint16_t tinyNeoPixel::getInterruptsOffMicros(void) const {
+  return blockedMicros;
+}
 
+// Streaming output, for strips too long to keep a frame buffer for: each
+// pixel is put together in a few bytes on the stack and sent on its own,
+// the data line idling low in between. The LEDs latch when it stays low
+// for longer than their reset time, so the time between pixels (the loop
+// and call, about 10 us at 8 MHz, 15 more with setBrightness(), plus the
+// generator) has to stay below that. The
+// WS2812B and SK6812 wait 50 us or more; the original WS2812 only about
+// 6 us, which at 8 MHz leaves no room for a generator. Interrupts are off
+// throughout.
+void tinyNeoPixel::show(uint32_t (*generator)(uint16_t), uint16_t count) {
+  uint8_t pixel[4];
+  uint8_t bpp = (wOffset == rOffset) ? 3 : 4;
+  blockedMicros = bytesToMicros((uint32_t)count * bpp);
+  while(!canShow());
+  noInterrupts();
+  for(uint16_t n=0; n<count; n++) {
+    colorToBytes(generator(n), pixel);
+    sendBytes(pixel, bpp);
+  }
+  interrupts();
+  #ifndef DISABLEMILLIS
+  endTime = micros(); // Save EOD time for latch on next call
+  #endif
+}
 
+// Convert up to 16 palette colors to data stream order (4 bytes apart, so
+// finding one is a shift) with brightness applied; the rest are black.
+void tinyNeoPixel::paletteToBytes(const uint32_t *palette, uint8_t paletteSize, uint8_t *colors) const {
+  memset(colors, 0, 64);
+  if(paletteSize > 16) paletteSize = 16;
+  for(uint8_t c=0; c<paletteSize; c++) {
+    colorToBytes(palette[c], &colors[c << 2]);
+  }
+}
 
+// One palette index (0-15) per pixel.
+void tinyNeoPixel::showPalette(const uint8_t *indices, uint16_t count, const uint32_t *palette, uint8_t paletteSize) {
+  uint8_t colors[64];
+  uint8_t bpp = (wOffset == rOffset) ? 3 : 4;
+  paletteToBytes(palette, paletteSize, colors);
+  blockedMicros = bytesToMicros((uint32_t)count * bpp);
+  while(!canShow());
+  noInterrupts();
+  for(uint16_t n=0; n<count; n++) {
+    sendBytes(&colors[(indices[n] & 0x0F) << 2], bpp);
+  }
+  interrupts();
+  #ifndef DISABLEMILLIS
+  endTime = micros(); // Save EOD time for latch on next call
+  #endif
+}
 
+// Run length encoded: numRuns pairs of (number of pixels, palette index).
+void tinyNeoPixel::showRLE(const uint8_t *runs, uint16_t numRuns, const uint32_t *palette, uint8_t paletteSize) {
+  uint8_t colors[64];
+  uint8_t bpp = (wOffset == rOffset) ? 3 : 4;
+  uint32_t pixelCount = 0;
+  paletteToBytes(palette, paletteSize, colors);
+  for(uint16_t r=0; r<numRuns; r++) {
+    pixelCount += runs[r << 1];
+  }
+  blockedMicros = bytesToMicros(pixelCount * bpp);
+  while(!canShow());
+  noInterrupts();
+  while(numRuns--) {
+    uint8_t  len    = *runs++;
+    uint8_t *color  = &colors[(*runs++ & 0x0F) << 2];
+    while(len--) {
+      sendBytes(color, bpp);
+    }
+  }
   interrupts();
   #ifndef DISABLEMILLIS
   endTime = micros(); // Save EOD time for latch on next call
@@ -628,26 +780,28 @@ void tinyNeoPixel::setPixelColor(
 // Set pixel color from 'packed' 32-bit RGB color:
 void tinyNeoPixel::setPixelColor(uint16_t n, uint32_t c) {
   if(n < numLEDs) {
-    uint8_t *p,
-      r = (uint8_t)(c >> 16),
-      g = (uint8_t)(c >>  8),
-      b = (uint8_t)c;
-    if(brightness) { // See notes in setBrightness()
-      r = (r * brightness) >> 8;
-      g = (g * brightness) >> 8;
-      b = (b * brightness) >> 8;
-    }
-    if(wOffset == rOffset) {
-      p = &pixels[n * 3];
-    } else {
-      p = &pixels[n * 4];
-      uint8_t w = (uint8_t)(c >> 24);
-      p[wOffset] = brightness ? ((w * brightness) >> 8) : w;
-    }
-    p[rOffset] = r;
-    p[gOffset] = g;
-    p[bOffset] = b;
+    colorToBytes(c, &pixels[n * ((wOffset == rOffset) ? 3 : 4)]);
+  }
+}
+
+// Store a 'packed' color at p in data stream order, brightness applied:
+void tinyNeoPixel::colorToBytes(uint32_t c, uint8_t *p) const {
+  uint8_t
+    r = (uint8_t)(c >> 16),
+    g = (uint8_t)(c >>  8),
+    b = (uint8_t)c;
+  if(brightness) { // See notes in setBrightness()
+    r = scaleByte(r, brightness);
+    g = scaleByte(g, brightness);
+    b = scaleByte(b, brightness);
+  }
+  if(wOffset != rOffset) {
+    uint8_t w = (uint8_t)(c >> 24);
+    p[wOffset] = brightness ? scaleByte(w, brightness) : w;
   }
+  p[rOffset] = r;
+  p[gOffset] = g;
+  p[bOffset] = b;
 }
 
 // Query color from previously-set pixel (returns packed 32-bit RGB value)
@@ -719,6 +873,10 @@ void tinyNeoPixel::setBrightness(uint8_t b) {
   // adding 1 here may (intentionally) roll over...so 0 = max brightness
   // (color values are interpreted literally; no scaling), 1 = min
   // brightness (off), 255 = just below max brightness.
+  if(brightnessOnShow) { // Nothing to rescale, see applyBrightnessOnShow()
+    showBrightness = b + 1;
+    return;
+  }
   uint8_t newBrightness = b + 1;
   if(newBrightness != brightness) { // Compare against prior value
     // Brightness has changed -- re-scale existing data in RAM
@@ -739,9 +897,124 @@ void tinyNeoPixel::setBrightness(uint8_t b) {
 
 //Return the brightness value
 uint8_t tinyNeoPixel::getBrightness(void) const {
-  return brightness - 1;
+  return (brightnessOnShow ? showBrightness : brightness) - 1;
 }
 
 void tinyNeoPixel::clear() {
   memset(pixels, 0, numBytes);
 }
+
+// Bulk operations. These convert a color once (or not at all) and work on
+// the buffer directly, instead of going through setPixelColor() per pixel.
+
+// Set count pixels from first on (to the end if count is 0) to one color.
+void tinyNeoPixel::fill(uint32_t c, uint16_t first, uint16_t count) {
+  uint8_t bytes[4];
+  uint8_t bpp = (wOffset == rOffset) ? 3 : 4;
+  if(first >= numLEDs) return;
+  if(!count || count > numLEDs - first) count = numLEDs - first;
+  colorToBytes(c, bytes);
+  uint8_t *p = &pixels[first * bpp];
+  while(count--) {
+    for(uint8_t i=0; i<bpp; i++) *p++ = bytes[i];
+  }
+}
+
+// Fade from c1 at pixel first to c2 at the last of count pixels (to the end
+// if count is 0), stepping each byte with a fixed point accumulator.
+void tinyNeoPixel::fillGradient(uint32_t c1, uint32_t c2, uint16_t first, uint16_t count) {
+  uint8_t  from[4], to[4];
+  uint16_t acc[4];
+  int16_t  step[4];
+  uint8_t  bpp = (wOffset == rOffset) ? 3 : 4;
+  if(first >= numLEDs) return;
+  if(!count || count > numLEDs - first) count = numLEDs - first;
+  if(count < 3) { // Too short for a 16 bit step
+    fill(c1, first, 1);
+    if(count == 2) fill(c2, first + 1, 1);
+    return;
+  }
+  colorToBytes(c1, from);
+  colorToBytes(c2, to);
+  for(uint8_t i=0; i<bpp; i++) {
+    acc[i]  = ((uint16_t)from[i] << 8) | 0x80;
+    step[i] = ((int32_t)((int16_t)to[i] - from[i]) << 8) / (int32_t)(count - 1);
+  }
+  uint8_t *p = &pixels[first * bpp];
+  while(count--) {
+    for(uint8_t i=0; i<bpp; i++) {
+      *p++    = acc[i] >> 8;
+      acc[i] += step[i];
+    }
+  }
+}
+
+// Move every pixel n places up the strip (down if n is negative). The
+// pixels which come free are cleared.
+void tinyNeoPixel::scroll(int16_t n) {
+  uint8_t  bpp = (wOffset == rOffset) ? 3 : 4;
+  uint16_t places = (n < 0) ? -n : n;
+  if(places >= numLEDs) {
+    clear();
+    return;
+  }
+  uint16_t bytes = places * bpp;
+  if(n > 0) {
+    memmove(pixels + bytes, pixels, numBytes - bytes);
+    memset(pixels, 0, bytes);
+  } else if(n < 0) {
+    memmove(pixels, pixels + bytes, numBytes - bytes);
+    memset(pixels + numBytes - bytes, 0, bytes);
+  }
+}
+
+// Scale every pixel by scale/256, e.g. 224 each frame for a fading trail.
+void tinyNeoPixel::fadeAll(uint8_t scale) {
+  uint8_t *ptr = pixels;
+  uint16_t len = numBytes;
+  while(len--) {
+    *ptr = (*ptr * scale) >> 8;
+    ptr++;
+  }
+}
+
+// With this on, colors are stored as given and scaled by the brightness
+// while sending: setPixelColor() does no multiplies and setBrightness() no
+// longer loses color resolution or rewrites the buffer. Each pixel is then
+// scaled and sent on its own, with the data line idle while the next one is
+// scaled: about 25 us at 8 MHz for RGB (30 for RGBW), half that at 16 MHz,
+// which is inside the 50 us reset time of the WS2812B and SK6812 but not
+// the 6 us of the original WS2812.
+void tinyNeoPixel::applyBrightnessOnShow(boolean on) {
+  if(on == brightnessOnShow) return;
+  if(on) {
+    uint8_t b = getBrightness();
+    setBrightness(255);        // Buffer back to unscaled, as well as it can be
+    showBrightness = b + 1;
+    brightnessOnShow = true;
+  } else {
+    uint8_t b = showBrightness - 1;
+    brightnessOnShow = false;
+    setBrightness(b);          // Buffer is at full brightness; scale it
+  }
+}
+
+void tinyNeoPixel::sendScaled(void) {
+  uint8_t  pixel[4];
+  uint8_t  bpp = (wOffset == rOffset) ? 3 : 4;
+  uint8_t *ptr = pixels;
+  uint8_t  k   = 0;
+  blockedMicros = bytesToMicros((uint32_t)(interruptInterval ? interruptInterval : numLEDs) * bpp);
+  for(uint16_t n=0; n<numLEDs; n++) {
+    for(uint8_t i=0; i<bpp; i++) {
+      pixel[i] = scaleByte(*ptr++, showBrightness);
+    }
+    sendBytes(pixel, bpp);
+    if(interruptInterval && ++k == interruptInterval) { // See sendChunked()
+      k = 0;
+      interrupts();
+      __asm__ __volatile__("nop");
+      noInterrupts();
+    }
+  }
+}
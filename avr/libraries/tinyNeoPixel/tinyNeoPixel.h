@@ -177,6 +177,23 @@ class tinyNeoPixel {
     numPixels(void) const;
   uint32_t
     getPixelColor(uint16_t n) const;
+  // Bulk operations
+  void
+    fill(uint32_t c, uint16_t first=0, uint16_t count=0),
+    fillGradient(uint32_t c1, uint32_t c2, uint16_t first=0, uint16_t count=0),
+    scroll(int16_t n),
+    fadeAll(uint8_t scale),
+    applyBrightnessOnShow(boolean on);
+  // Interrupt tolerant show(), see sendChunked()
+  void
+    setInterruptInterval(uint8_t pixels);
+  uint16_t
+    getInterruptsOffMicros(void) const;
+  // Streaming output without a frame buffer, see tinyNeoPixel.cpp
+  void
+    show(uint32_t (*generator)(uint16_t), uint16_t count),
+    showPalette(const uint8_t *indices, uint16_t count, const uint32_t *palette, uint8_t paletteSize),
+    showRLE(const uint8_t *runs, uint16_t numRuns, const uint32_t *palette, uint8_t paletteSize);
   /*!
     @brief   An 8-bit integer sine wave function, not directly compatible
              with standard trigonometric units like radians or degrees.
@@ -260,6 +277,15 @@ class tinyNeoPixel {
 
  private:
 
+  void
+    colorToBytes(uint32_t c, uint8_t *p) const,
+    paletteToBytes(const uint32_t *palette, uint8_t paletteSize, uint8_t *colors) const;
+  __attribute__((noinline, noclone)) void
+    sendBytes(uint8_t *data, uint16_t count);
+  void
+    sendChunked(uint8_t *data, uint16_t count),
+    sendScaled(void);
+
   boolean
     begun;         // true if begin() previously called
   uint16_t
@@ -274,6 +300,14 @@ class tinyNeoPixel {
     gOffset,       // Index of green byte
     bOffset,       // Index of blue byte
     wOffset;       // Index of white byte (same as rOffset if no white)
+  uint8_t
+    interruptInterval; // Pixels between interrupt windows (0: none)
+  uint16_t
+    blockedMicros; // Longest interrupts-off stretch of the last show()
+  uint8_t
+    showBrightness; // Brightness applied by show(), like 'brightness'
+  boolean
+    brightnessOnShow; // See applyBrightnessOnShow()
   uint32_t
     endTime;       // Latch timing reference
   volatile uint8_t
@@ -37,7 +37,8 @@
 
 // Constructor when length, pin and type are known at compile-time:
 tinyNeoPixel::tinyNeoPixel(uint16_t n, uint8_t p, neoPixelType t, uint8_t *pxl) :
-  brightness(0), pixels(pxl), endTime(0)
+  brightness(0), pixels(pxl), indexBits(0), palette(NULL), paletteSize(0),
+  interruptInterval(0), blockedMicros(0), showBrightness(0), brightnessOnShow(false), endTime(0)
 {
   //boolean oldThreeBytesPerPixel = (wOffset == rOffset); // false if RGBW
 
@@ -58,12 +59,53 @@ tinyNeoPixel::tinyNeoPixel(uint16_t n, uint8_t p, neoPixelType t, uint8_t *pxl)
 
 
 
+// Constructor for a palette indexed buffer: pxl holds a 4 or 8 bit palette
+// index per pixel (see NEO_INDEX_BUFFER_SIZE()), and pal holds palSize
+// colors in data stream order, 3 or 4 bytes each, set by setPaletteColor().
+tinyNeoPixel::tinyNeoPixel(uint16_t n, uint8_t p, neoPixelType t, uint8_t *pxl, uint8_t bits, uint8_t *pal, uint16_t palSize) :
+  tinyNeoPixel(n, p, t, pxl)
+{
+  indexBits = bits;
+  palette = pal;
+  paletteSize = palSize;
+  numBytes = NEO_INDEX_BUFFER_SIZE(n, bits);
+}
+
 tinyNeoPixel::~tinyNeoPixel() {
   //if(pixels)   free(pixels);
   //if(pin >= 0) pinMode(pin, INPUT);
 }
 
 
+// (v * s) >> 8 by shifting and adding, in a fixed 33 cycles. None of these
+// parts has a hardware multiply, and the libgcc one takes several times as
+// long, which matters when it runs between pixels with the data line idle.
+#define NEO_SCALE_STEP(bit) \
+  "clc               \n\t" \
+  "sbrc %[s], " #bit "   \n\t" \
+  "add  %[r], %[v]   \n\t" \
+  "ror  %[r]         \n\t"
+
+static inline uint8_t scaleByte(uint8_t v, uint8_t s) __attribute__((always_inline));
+static inline uint8_t scaleByte(uint8_t v, uint8_t s) {
+  uint8_t r;
+  __asm__ (
+    "clr  %[r]         \n\t"
+    NEO_SCALE_STEP(0) NEO_SCALE_STEP(1) NEO_SCALE_STEP(2) NEO_SCALE_STEP(3)
+    NEO_SCALE_STEP(4) NEO_SCALE_STEP(5) NEO_SCALE_STEP(6) NEO_SCALE_STEP(7)
+    : [r] "=&r" (r)
+    : [v] "r" (v), [s] "r" (s)
+  );
+  return r;
+}
+
+// Only the 800 kHz bitstream is supported (there is no NEO_KHZ400 here), so
+// each byte is 8 bits of 1.25 us. Saturates rather than wrapping on long strips.
+static uint16_t bytesToMicros(uint32_t count) {
+  count *= 10;
+  return (count > 0xFFFF) ? 0xFFFF : count;
+}
+
 void tinyNeoPixel::show(void) {
 
   if(!pixels) return;
@@ -90,14 +132,34 @@ void tinyNeoPixel::show(void) {
   // to the PORT register as needed.
 
   noInterrupts(); // Need 100% focus on instruction timing
+  if(indexBits) {
+    sendIndexed();
+  } else if(brightnessOnShow && showBrightness) {
+    sendScaled();
+  } else if(interruptInterval) {
+    sendChunked(pixels, numBytes);
+  } else {
+    blockedMicros = bytesToMicros(numBytes);
+    sendBytes(pixels, numBytes);
+  }
+  interrupts();
+  #ifndef DISABLEMILLIS
+  endTime = micros(); // Save EOD time for latch on next call
+  #endif
+}
+
+// Issue count bytes starting at data to the LEDs; interrupts must already
+// be off. Never inlined or cloned, as the asm labels may only appear once.
+void tinyNeoPixel::sendBytes(uint8_t *data, uint16_t count) {
 
+  if(!count) return;
 
 // AVR MCUs --  ATtiny and megaAVR ATtiny -------------------------------
 
   volatile uint16_t
-    i   = numBytes; // Loop counter
+    i   = count;    // Loop counter
   volatile uint8_t
-   *ptr = pixels,   // Pointer to next byte
+   *ptr = data,     // Pointer to next byte
     b   = *ptr++,   // Current byte value
     hi,             // PORT w/output bit set high
     lo;             // PORT w/output bit set low
@@ -653,12 +715,157 @@ void tinyNeoPixel::show(void) {
 #endif
 
 // END AVR ----------------------------------------------------------------
+}
+
+// Interrupt tolerant output: after every interruptInterval pixels, with the
+// data line low, interrupts are enabled for an instruction so that anything
+// pending (the millis timer, serial receive) runs. Only one interrupt gets in
+// each time: the AVR runs one instruction after a reti before taking the next,
+// and that is the cli. The LEDs only latch when the line stays low for their
+// reset time (50 us or more on WS2812B and SK6812), so every interrupt that
+// can fire has to finish well within that.
+void tinyNeoPixel::sendChunked(uint8_t *data, uint16_t count) {
+  uint16_t chunk = interruptInterval * ((wOffset == rOffset) ? 3 : 4);
+  blockedMicros = bytesToMicros(count < chunk ? count : chunk);
+  while(count) {
+    uint16_t n = (count < chunk) ? count : chunk;
+    sendBytes(data, n);
+    data  += n;
+    count -= n;
+    interrupts();
+    __asm__ __volatile__("nop");
+    noInterrupts();
+  }
+}
+
+// Pixels to send between interrupt windows, 0 (the default) for none.
+void tinyNeoPixel::setInterruptInterval(uint8_t pixels) {
+  interruptInterval = pixels;
+}
+
+// The longest stretch the last show() kept interrupts off for, worked out
+// from the number of bytes. Timer overflows which fall in a stretch longer
+// than their period are lost to millis(); nothing here puts them back, that
+// is left to the sketch.
+uint16_t tinyNeoPixel::getInterruptsOffMicros(void) const {
+  return blockedMicros;
+}
+
+// Indexed buffers: each pixel's entry in the palette (which is kept in data
+// stream order) is sent on its own, as in the streaming modes below, and
+// scaled on the way if applyBrightnessOnShow() is on.
+void tinyNeoPixel::sendIndexed(void) {
+  uint8_t  bpp = (wOffset == rOffset) ? 3 : 4;
+  uint8_t *ptr = pixels;
+  uint8_t  k   = 0;
+  blockedMicros = bytesToMicros((uint32_t)(interruptInterval ? interruptInterval : numLEDs) * bpp);
+  for(uint16_t n=0; n<numLEDs; n++) {
+    uint8_t i = *ptr;
+    if(indexBits == NEO_INDEX4) {
+      if(n & 1) {
+        i >>= 4;
+        ptr++;
+      } else {
+        i &= 0x0F;
+      }
+    } else {
+      ptr++;
+    }
+    uint16_t offset = i;  // i * bpp, without a multiply
+    offset = (bpp == 4) ? (offset << 2) : (offset + (offset << 1));
+    if(brightnessOnShow && showBrightness) { // As in sendScaled()
+      uint8_t pixel[4];
+      for(uint8_t j=0; j<bpp; j++) {
+        pixel[j] = scaleByte(palette[offset + j], showBrightness);
+      }
+      sendBytes(pixel, bpp);
+    } else {
+      sendBytes(&palette[offset], bpp);
+    }
+    if(interruptInterval && ++k == interruptInterval) { // See sendChunked()
+      k = 0;
+      interrupts();
+      __asm__ __volatile__("nop");
+      noInterrupts();
+    }
+  }
+}
 
+// Streaming output, for strips too long to keep a frame buffer for: each
+// pixel is put together in a few bytes on the stack and sent on its own,
+// the data line idling low in between. The LEDs latch when it stays low
+// for longer than their reset time, so the time between pixels (the loop
+// and call, about 10 us at 8 MHz, 15 more with setBrightness(), plus the
+// generator) has to stay below that. The
+// WS2812B and SK6812 wait 50 us or more; the original WS2812 only about
+// 6 us, which at 8 MHz leaves no room for a generator. Interrupts are off
+// throughout.
+void tinyNeoPixel::show(uint32_t (*generator)(uint16_t), uint16_t count) {
+  uint8_t pixel[4];
+  uint8_t bpp = (wOffset == rOffset) ? 3 : 4;
+  blockedMicros = bytesToMicros((uint32_t)count * bpp);
+  while(!canShow());
+  noInterrupts();
+  for(uint16_t n=0; n<count; n++) {
+    colorToBytes(generator(n), pixel);
+    sendBytes(pixel, bpp);
+  }
+  interrupts();
+  #ifndef DISABLEMILLIS
+  endTime = micros(); // Save EOD time for latch on next call
+  #endif
+}
 
+// Convert up to 16 palette colors to data stream order (4 bytes apart, so
+// finding one is a shift) with brightness applied; the rest are black.
+void tinyNeoPixel::paletteToBytes(const uint32_t *palette, uint8_t paletteSize, uint8_t *colors) const {
+  memset(colors, 0, 64);
+  if(paletteSize > 16) paletteSize = 16;
+  for(uint8_t c=0; c<paletteSize; c++) {
+    colorToBytes(palette[c], &colors[c << 2]);
+  }
+}
+
+// One palette index (0-15) per pixel.
+void tinyNeoPixel::showPalette(const uint8_t *indices, uint16_t count, const uint32_t *palette, uint8_t paletteSize) {
+  uint8_t colors[64];
+  uint8_t bpp = (wOffset == rOffset) ? 3 : 4;
+  paletteToBytes(palette, paletteSize, colors);
+  blockedMicros = bytesToMicros((uint32_t)count * bpp);
+  while(!canShow());
+  noInterrupts();
+  for(uint16_t n=0; n<count; n++) {
+    sendBytes(&colors[(indices[n] & 0x0F) << 2], bpp);
+  }
   interrupts();
-#ifndef DISABLEMILLIS
+  #ifndef DISABLEMILLIS
   endTime = micros(); // Save EOD time for latch on next call
-#endif
+  #endif
+}
+
+// Run length encoded: numRuns pairs of (number of pixels, palette index).
+void tinyNeoPixel::showRLE(const uint8_t *runs, uint16_t numRuns, const uint32_t *palette, uint8_t paletteSize) {
+  uint8_t colors[64];
+  uint8_t bpp = (wOffset == rOffset) ? 3 : 4;
+  uint32_t pixelCount = 0;
+  paletteToBytes(palette, paletteSize, colors);
+  for(uint16_t r=0; r<numRuns; r++) {
+    pixelCount += runs[r << 1];
+  }
+  blockedMicros = bytesToMicros(pixelCount * bpp);
+  while(!canShow());
+  noInterrupts();
+  while(numRuns--) {
+    uint8_t  len    = *runs++;
+    uint8_t *color  = &colors[(*runs++ & 0x0F) << 2];
+    while(len--) {
+      sendBytes(color, bpp);
+    }
+  }
+  interrupts();
+  #ifndef DISABLEMILLIS
+  endTime = micros(); // Save EOD time for latch on next call
+  #endif
 }
 
 // Set the output pin number
@@ -672,7 +879,7 @@ void tinyNeoPixel::setPin(uint8_t p) {
 void tinyNeoPixel::setPixelColor(
  uint16_t n, uint8_t r, uint8_t g, uint8_t b) {
 
-  if(n < numLEDs) {
+  if(n < numLEDs && !indexBits) {
     if(brightness) { // See notes in setBrightness()
       r = (r * brightness) >> 8;
       g = (g * brightness) >> 8;
@@ -694,7 +901,7 @@ void tinyNeoPixel::setPixelColor(
 void tinyNeoPixel::setPixelColor(
  uint16_t n, uint8_t r, uint8_t g, uint8_t b, uint8_t w) {
 
-  if(n < numLEDs) {
+  if(n < numLEDs && !indexBits) {
     if(brightness) { // See notes in setBrightness()
       r = (r * brightness) >> 8;
       g = (g * brightness) >> 8;
@@ -716,29 +923,61 @@ void tinyNeoPixel::setPixelColor(
 
 // Set pixel color from 'packed' 32-bit RGB color:
 void tinyNeoPixel::setPixelColor(uint16_t n, uint32_t c) {
-  if(n < numLEDs) {
-    uint8_t *p,
-      r = (uint8_t)(c >> 16),
-      g = (uint8_t)(c >>  8),
-      b = (uint8_t)c;
-    if(brightness) { // See notes in setBrightness()
-      r = (r * brightness) >> 8;
-      g = (g * brightness) >> 8;
-      b = (b * brightness) >> 8;
-    }
-    if(wOffset == rOffset) {
-      p = &pixels[n * 3];
-    } else {
-      p = &pixels[n * 4];
-      uint8_t w = (uint8_t)(c >> 24);
-      p[wOffset] = brightness ? ((w * brightness) >> 8) : w;
+  if(n < numLEDs && !indexBits) {
+    colorToBytes(c, &pixels[n * ((wOffset == rOffset) ? 3 : 4)]);
+  }
+}
+
+// Store a 'packed' color at p in data stream order, brightness applied:
+void tinyNeoPixel::colorToBytes(uint32_t c, uint8_t *p) const {
+  uint8_t
+    r = (uint8_t)(c >> 16),
+    g = (uint8_t)(c >>  8),
+    b = (uint8_t)c;
+  if(brightness) { // See notes in setBrightness()
+    r = scaleByte(r, brightness);
+    g = scaleByte(g, brightness);
+    b = scaleByte(b, brightness);
+  }
+  if(wOffset != rOffset) {
+    uint8_t w = (uint8_t)(c >> 24);
+    p[wOffset] = brightness ? scaleByte(w, brightness) : w;
+  }
+  p[rOffset] = r;
+  p[gOffset] = g;
+  p[bOffset] = b;
+}
+
+// Set palette entry i of an indexed buffer from a 'packed' color:
+void tinyNeoPixel::setPaletteColor(uint8_t i, uint32_t c) {
+  if(i < paletteSize) {
+    colorToBytes(c, &palette[i * ((wOffset == rOffset) ? 3 : 4)]);
+  }
+}
+
+// Set pixel n of an indexed buffer to palette entry i:
+void tinyNeoPixel::setPixelIndex(uint16_t n, uint8_t i) {
+  if(n < numLEDs && i < paletteSize) {
+    if(indexBits == NEO_INDEX4) {
+      uint8_t *p = &pixels[n >> 1];
+      if(n & 1) {
+        *p = (*p & 0x0F) | (i << 4);
+      } else {
+        *p = (*p & 0xF0) | i;
+      }
+    } else if(indexBits) {
+      pixels[n] = i;
     }
-    p[rOffset] = r;
-    p[gOffset] = g;
-    p[bOffset] = b;
   }
 }
 
+uint8_t tinyNeoPixel::getPixelIndex(uint16_t n) const {
+  if(n >= numLEDs || !indexBits) return 0;
+  if(indexBits == NEO_INDEX4) {
+    return (n & 1) ? (pixels[n >> 1] >> 4) : (pixels[n >> 1] & 0x0F);
+  }
+  return pixels[n];
+}
 
 // Query color from previously-set pixel (returns packed 32-bit RGB value)
 uint32_t tinyNeoPixel::getPixelColor(uint16_t n) const {
@@ -747,7 +986,7 @@ uint32_t tinyNeoPixel::getPixelColor(uint16_t n) const {
   uint8_t *p;
 
   if(wOffset == rOffset) { // Is RGB-type device
-    p = &pixels[n * 3];
+    p = indexBits ? &palette[getPixelIndex(n) * 3] : &pixels[n * 3];
     if(brightness) {
       // Stored color was decimated by setBrightness().  Returned value
       // attempts to scale back to an approximation of the original 24-bit
@@ -764,7 +1003,7 @@ uint32_t tinyNeoPixel::getPixelColor(uint16_t n) const {
               (uint32_t)p[bOffset];
     }
   } else {                 // Is RGBW-type device
-    p = &pixels[n * 4];
+    p = indexBits ? &palette[getPixelIndex(n) * 4] : &pixels[n * 4];
     if(brightness) { // Return scaled color
       return (((uint32_t)(p[wOffset] << 8) / brightness) << 24) |
              (((uint32_t)(p[rOffset] << 8) / brightness) << 16) |
@@ -809,17 +1048,23 @@ void tinyNeoPixel::setBrightness(uint8_t b) {
   // adding 1 here may (intentionally) roll over...so 0 = max brightness
   // (color values are interpreted literally; no scaling), 1 = min
   // brightness (off), 255 = just below max brightness.
+  if(brightnessOnShow) { // Nothing to rescale, see applyBrightnessOnShow()
+    showBrightness = b + 1;
+    return;
+  }
   uint8_t newBrightness = b + 1;
   if(newBrightness != brightness) { // Compare against prior value
-    // Brightness has changed -- re-scale existing data in RAM
+    // Brightness has changed -- re-scale existing data in RAM (for an
+    // indexed buffer, that's the palette)
     uint8_t  c,
-            *ptr           = pixels,
+            *ptr           = indexBits ? palette : pixels,
              oldBrightness = brightness - 1; // De-wrap old brightness value
-    uint16_t scale;
+    uint16_t scale,
+             len           = indexBits ? paletteSize * ((wOffset == rOffset) ? 3 : 4) : numBytes;
     if(oldBrightness == 0) scale = 0; // Avoid /0
     else if(b == 255) scale = 65535 / oldBrightness;
     else scale = (((uint16_t)newBrightness << 8) - 1) / oldBrightness;
-    for(uint16_t i=0; i<numBytes; i++) {
+    for(uint16_t i=0; i<len; i++) {
       c      = *ptr;
       *ptr++ = (c * scale) >> 8;
     }
@@ -829,9 +1074,126 @@ void tinyNeoPixel::setBrightness(uint8_t b) {
 
 //Return the brightness value
 uint8_t tinyNeoPixel::getBrightness(void) const {
-  return brightness - 1;
+  return (brightnessOnShow ? showBrightness : brightness) - 1;
 }
 
 void tinyNeoPixel::clear() {
   memset(pixels, 0, numBytes);
 }
+
+// Bulk operations. These convert a color once (or not at all) and work on
+// the buffer directly, instead of going through setPixelColor() per pixel.
+
+// Set count pixels from first on (to the end if count is 0) to one color.
+void tinyNeoPixel::fill(uint32_t c, uint16_t first, uint16_t count) {
+  uint8_t bytes[4];
+  uint8_t bpp = (wOffset == rOffset) ? 3 : 4;
+  if(first >= numLEDs || indexBits) return;
+  if(!count || count > numLEDs - first) count = numLEDs - first;
+  colorToBytes(c, bytes);
+  uint8_t *p = &pixels[first * bpp];
+  while(count--) {
+    for(uint8_t i=0; i<bpp; i++) *p++ = bytes[i];
+  }
+}
+
+// Fade from c1 at pixel first to c2 at the last of count pixels (to the end
+// if count is 0), stepping each byte with a fixed point accumulator.
+void tinyNeoPixel::fillGradient(uint32_t c1, uint32_t c2, uint16_t first, uint16_t count) {
+  uint8_t  from[4], to[4];
+  uint16_t acc[4];
+  int16_t  step[4];
+  uint8_t  bpp = (wOffset == rOffset) ? 3 : 4;
+  if(first >= numLEDs || indexBits) return;
+  if(!count || count > numLEDs - first) count = numLEDs - first;
+  if(count < 3) { // Too short for a 16 bit step
+    fill(c1, first, 1);
+    if(count == 2) fill(c2, first + 1, 1);
+    return;
+  }
+  colorToBytes(c1, from);
+  colorToBytes(c2, to);
+  for(uint8_t i=0; i<bpp; i++) {
+    acc[i]  = ((uint16_t)from[i] << 8) | 0x80;
+    step[i] = ((int32_t)((int16_t)to[i] - from[i]) << 8) / (int32_t)(count - 1);
+  }
+  uint8_t *p = &pixels[first * bpp];
+  while(count--) {
+    for(uint8_t i=0; i<bpp; i++) {
+      *p++    = acc[i] >> 8;
+      acc[i] += step[i];
+    }
+  }
+}
+
+// Move every pixel n places up the strip (down if n is negative). The
+// pixels which come free are cleared.
+void tinyNeoPixel::scroll(int16_t n) {
+  uint8_t  bpp = (wOffset == rOffset) ? 3 : 4;
+  uint16_t places = (n < 0) ? -n : n;
+  if(indexBits) return;
+  if(places >= numLEDs) {
+    clear();
+    return;
+  }
+  uint16_t bytes = places * bpp;
+  if(n > 0) {
+    memmove(pixels + bytes, pixels, numBytes - bytes);
+    memset(pixels, 0, bytes);
+  } else if(n < 0) {
+    memmove(pixels, pixels + bytes, numBytes - bytes);
+    memset(pixels + numBytes - bytes, 0, bytes);
+  }
+}
+
+// Scale every pixel (the palette, for an indexed buffer) by scale/256,
+// e.g. 224 each frame for a fading trail.
+void tinyNeoPixel::fadeAll(uint8_t scale) {
+  uint8_t *ptr = indexBits ? palette : pixels;
+  uint16_t len = indexBits ? paletteSize * ((wOffset == rOffset) ? 3 : 4) : numBytes;
+  while(len--) {
+    *ptr = (*ptr * scale) >> 8;
+    ptr++;
+  }
+}
+
+// With this on, colors are stored as given and scaled by the brightness
+// while sending: setPixelColor() does no multiplies and setBrightness() no
+// longer loses color resolution or rewrites the buffer. Each pixel is then
+// scaled and sent on its own, with the data line idle while the next one is
+// scaled: about 25 us at 8 MHz for RGB (30 for RGBW), half that at 16 MHz,
+// which is inside the 50 us reset time of the WS2812B and SK6812 but not
+// the 6 us of the original WS2812.
+void tinyNeoPixel::applyBrightnessOnShow(boolean on) {
+  if(on == brightnessOnShow) return;
+  if(on) {
+    uint8_t b = getBrightness();
+    setBrightness(255);        // Buffer back to unscaled, as well as it can be
+    showBrightness = b + 1;
+    brightnessOnShow = true;
+  } else {
+    uint8_t b = showBrightness - 1;
+    brightnessOnShow = false;
+    setBrightness(b);          // Buffer is at full brightness; scale it
+  }
+}
+
+void tinyNeoPixel::sendScaled(void) {
+  uint8_t  pixel[4];
+  uint8_t  bpp = (wOffset == rOffset) ? 3 : 4;
+  uint8_t *ptr = pixels;
+  uint8_t  k   = 0;
+  blockedMicros = bytesToMicros((uint32_t)(interruptInterval ? interruptInterval : numLEDs) * bpp);
+  for(uint16_t n=0; n<numLEDs; n++) {
+    for(uint8_t i=0; i<bpp; i++) {
+      pixel[i] = scaleByte(*ptr++, showBrightness);
+    }
+    sendBytes(pixel, bpp);
+    if(interruptInterval && ++k == interruptInterval) { // See sendChunked()
+      k = 0;
+      interrupts();
+      __asm__ __volatile__("nop");
+      noInterrupts();
+    }
+  }
+}
@@ -148,12 +148,21 @@ static const uint8_t PROGMEM _NeoPixelGammaTable[256] = {
 
 typedef uint8_t  neoPixelType;
 
+// Palette indexed buffers: bits per pixel, and the size of the buffer for n
+// pixels to pass to the constructor.
+#define NEO_INDEX4 4
+#define NEO_INDEX8 8
+#define NEO_INDEX_BUFFER_SIZE(n, bits) ((bits) == NEO_INDEX4 ? ((n) + 1) / 2 : (n))
+
 class tinyNeoPixel {
 
  public:
 
   // Constructor: number of LEDs, pin number, LED type
   tinyNeoPixel(uint16_t n, uint8_t p, neoPixelType t,uint8_t *pxl);
+  // Palette indexed buffer: number of LEDs, pin number, LED type, index
+  // buffer, NEO_INDEX4 or NEO_INDEX8, palette buffer, palette entries
+  tinyNeoPixel(uint16_t n, uint8_t p, neoPixelType t, uint8_t *pxl, uint8_t bits, uint8_t *pal, uint16_t palSize);
   ~tinyNeoPixel();
 
   void
@@ -163,9 +172,12 @@ class tinyNeoPixel {
     setPixelColor(uint16_t n, uint8_t r, uint8_t g, uint8_t b, uint8_t w),
     setPixelColor(uint16_t n, uint32_t c),
     setBrightness(uint8_t),
+    setPaletteColor(uint8_t i, uint32_t c),
+    setPixelIndex(uint16_t n, uint8_t i),
     clear();
   uint8_t
    *getPixels(void) const,
+    getPixelIndex(uint16_t n) const,
     getBrightness(void) const;
   int8_t
     getPin(void) { return pin; };
@@ -173,6 +185,23 @@ class tinyNeoPixel {
     numPixels(void) const;
   uint32_t
     getPixelColor(uint16_t n) const;
+  // Bulk operations
+  void
+    fill(uint32_t c, uint16_t first=0, uint16_t count=0),
+    fillGradient(uint32_t c1, uint32_t c2, uint16_t first=0, uint16_t count=0),
+    scroll(int16_t n),
+    fadeAll(uint8_t scale),
+    applyBrightnessOnShow(boolean on);
+  // Interrupt tolerant show(), see sendChunked()
+  void
+    setInterruptInterval(uint8_t pixels);
+  uint16_t
+    getInterruptsOffMicros(void) const;
+  // Streaming output without a frame buffer, see tinyNeoPixel_Static.cpp
+  void
+    show(uint32_t (*generator)(uint16_t), uint16_t count),
+    showPalette(const uint8_t *indices, uint16_t count, const uint32_t *palette, uint8_t paletteSize),
+    showRLE(const uint8_t *runs, uint16_t numRuns, const uint32_t *palette, uint8_t paletteSize);
   /*!
     @brief   An 8-bit integer sine wave function, not directly compatible
              with standard trigonometric units like radians or degrees.
@@ -256,6 +285,17 @@ class tinyNeoPixel {
 
  private:
 
+  void
+    colorToBytes(uint32_t c, uint8_t *p) const,
+    paletteToBytes(const uint32_t *palette, uint8_t paletteSize, uint8_t *colors) const;
+  __attribute__((noinline, noclone)) void
+    sendBytes(uint8_t *data, uint16_t count);
+  void
+    sendChunked(uint8_t *data, uint16_t count),
+    sendScaled(void);
+  void
+    sendIndexed(void);
+
   boolean
     begun;         // true if begin() previously called
   uint16_t
@@ -269,7 +309,19 @@ class tinyNeoPixel {
     rOffset,       // Index of red byte within each 3- or 4-byte pixel
     gOffset,       // Index of green byte
     bOffset,       // Index of blue byte
-    wOffset;       // Index of white byte (same as rOffset if no white)
+    wOffset,       // Index of white byte (same as rOffset if no white)
+    indexBits,     // 0, or bits per pixel of an indexed buffer
+   *palette;       // Palette of an indexed buffer, in data stream order
+  uint16_t
+    paletteSize;   // Number of palette entries
+  uint8_t
+    interruptInterval; // Pixels between interrupt windows (0: none)
+  uint16_t
+    blockedMicros; // Longest interrupts-off stretch of the last show()
+  uint8_t
+    showBrightness; // Brightness applied by show(), like 'brightness'
+  boolean
+    brightnessOnShow; // See applyBrightnessOnShow()
   uint32_t
     endTime;       // Latch timing reference
   volatile uint8_t
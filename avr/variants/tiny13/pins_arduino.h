@@ -234,6 +234,12 @@ static const uint8_t A3 = 0x80 | 3;
 #define digitalPinToPCMSK(p)    (((p) >= 0 && (p) <= 5) ? (&PCMSK) : ((uint8_t *)NULL))
 #define digitalPinToPCMSKbit(p) (p)
 
+// Pin change interrupt ports, for attachPinChangeInterrupt(): the vector,
+// input register and mask register of each, numbered as their PCMSK
+#define PCINT_PORT0_VECT    PCINT0_vect
+#define PCINT_PORT0_PIN     PINB
+#define PCINT_PORT0_PCMSK   PCMSK
+
 // External Interrupts on pins
 #define digitalPinToInterrupt(p) ( (p) == 1 ? 0 : NOT_AN_INTERRUPT )
 
@@ -164,6 +164,15 @@ static const uint8_t A3 = 0x80 | 3;
 #define digitalPinToPCMSK(p)    (((p) >= 0 && (p) <= 7) ? (&PCMSK1) : ((p) <= 15) ? (&PCMSK0) : ((uint8_t *)NULL))
 #define digitalPinToPCMSKbit(p) ((p)&0x07)
 
+// Pin change interrupt ports, for attachPinChangeInterrupt(): the vector,
+// input register and mask register of each, numbered as their PCMSK
+#define PCINT_PORT0_VECT    PCINT0_vect
+#define PCINT_PORT0_PIN     PINA
+#define PCINT_PORT0_PCMSK   PCMSK0
+#define PCINT_PORT1_VECT    PCINT1_vect
+#define PCINT_PORT1_PIN     PINB
+#define PCINT_PORT1_PCMSK   PCMSK1
+
 #define digitalPinToInterrupt(p)  ((p) == 7 ? 0 : NOT_AN_INTERRUPT)
 #ifdef ARDUINO_MAIN
 
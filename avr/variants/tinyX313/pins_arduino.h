@@ -159,6 +159,16 @@ static const uint8_t SCL = 16;
 #define digitalPinToPCMSK(p)    (((p) >= 9 && (p) <= 16) ? (&PCMSK) : ((uint8_t *)NULL))
 #define digitalPinToPCMSKbit(p) ((p) - 9)
 
+// Pin change interrupt ports, for attachPinChangeInterrupt(): the vector,
+// input register and mask register of each, numbered as their PCMSK
+#if defined(PCINT_B_vect)
+  #define PCINT_PORT0_VECT  PCINT_B_vect
+#else
+  #define PCINT_PORT0_VECT  PCINT_vect
+#endif
+#define PCINT_PORT0_PIN     PINB
+#define PCINT_PORT0_PCMSK   PCMSK
+
 
 #define digitalPinToInterrupt(p)  ((p) == 5 ? 1 : ((p)==4?0: NOT_AN_INTERRUPT))
 
@@ -215,6 +215,15 @@ static const uint8_t A7 = 0x80 | 7;
   ( (p-8) ))))          \
 )
 
+// Pin change interrupt ports, for attachPinChangeInterrupt(): the vector,
+// input register and mask register of each, numbered as their PCMSK
+#define PCINT_PORT0_VECT    PCINT0_vect
+#define PCINT_PORT0_PIN     PINA
+#define PCINT_PORT0_PCMSK   PCMSK0
+#define PCINT_PORT1_VECT    PCINT1_vect
+#define PCINT_PORT1_PIN     PINB
+#define PCINT_PORT1_PCMSK   PCMSK1
+
 // External Interrupts on pins
 #define digitalPinToInterrupt(p) ( (p) == 8 ? 0 : NOT_AN_INTERRUPT )
 
@@ -40,6 +40,11 @@
 
 #define ADC_TEMPERATURE 63
 
+// Each differential channel has two gains, selected by GSEL in ADCSRB, OR
+// this into the channel (MUX) number to get the higher one, for example
+// analogRead(ADC_HIGH_GAIN(0x0B)) is ADC0-ADC1 at 32x instead of 20x.
+#define ADC_HIGH_GAIN(ch) ((ch) | 0x40)
+
 //This part has a USI, not an SPI module. Accordingly, there is no MISO/MOSI in hardware. There's a DI and a DO. When the chip is used as master, DI is used as MISO, DO is MOSI; the defines here specify the pins for master mode, as SPI master is much more commonly used in Arduino-land than SPI slave, and these defines are required for compatibility. Be aware of this when using the USI SPI fucntionality (and also, be aware that the MISO and MOSI markings on the pinout diagram in the datasheet are for ISP programming, where the chip is a slave. The pinout diagram included with this core attempts to clarify this)
 
 
@@ -161,6 +166,17 @@ static const uint8_t A10 = 0x80 | 10;
 #define digitalPinToPCMSK(p)    (((p) >= 0 && (p) <= 16) ? ((p<8)?(&PCMSK0) : (&PCMSK1)) : ((uint8_t *)NULL))
 #define digitalPinToPCMSKbit(p) ((p) & 0x07)
 
+// Pin change interrupt ports, for attachPinChangeInterrupt(): the vector,
+// input register and mask register of each, numbered as their PCMSK.  There
+// is only the one vector, port 1 is dispatched from port 0's interrupt.
+#define PCINT_PORT0_VECT    PCINT_vect
+#define PCINT_PORT0_PIN     PINA
+#define PCINT_PORT0_PCMSK   PCMSK0
+#define PCINT_PORT0_SHARES  1
+#define PCINT_PORT1_PIN     PINB
+#define PCINT_PORT1_PCMSK   PCMSK1
+#define PCINT_PORT1_SHARES  0
+
 
 #define digitalPinToInterrupt(p)  ((p) == 14 ? 0 : ((p)==2?1: NOT_AN_INTERRUPT))
 
@@ -179,7 +179,16 @@ static const uint8_t A10 = 0x80 | 10;
 #define digitalPinToPCICR(p)    (&PCICR)
 #define digitalPinToPCICRbit(p) ((p) >= 8 ? 1 : 0)
 #define digitalPinToPCMSK(p)    ((p) >= 8 ?(&PCMSK1) : (&PCMSK0))
-#define digitalPinToPCMSKbit(p) (p&15)
+#define digitalPinToPCMSKbit(p) ((p)&7)
+
+// Pin change interrupt ports, for attachPinChangeInterrupt(): the vector,
+// input register and mask register of each, numbered as their PCMSK
+#define PCINT_PORT0_VECT    PCINT0_vect
+#define PCINT_PORT0_PIN     PINA
+#define PCINT_PORT0_PCMSK   PCMSK0
+#define PCINT_PORT1_VECT    PCINT1_vect
+#define PCINT_PORT1_PIN     PINB
+#define PCINT_PORT1_PCMSK   PCMSK1
 
 #define digitalPinToInterrupt(p)  ((p) == PIN_PB6 ? 0 : ((p)==PIN_PA3?1: NOT_AN_INTERRUPT))
 #ifdef ARDUINO_MAIN
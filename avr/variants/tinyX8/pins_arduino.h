@@ -133,6 +133,21 @@ static const uint8_t A7 = 0x80 | 7;
 #define digitalPinToPCMSK(p)    (((p) <= 7) ? (&PCMSK2) : (((p) <= 15) ? (&PCMSK0) : (((p) <= 22) ? (&PCMSK1) : (((p) <= 26) ? (&PCMSK3) : ((uint8_t *)0)))))
 #define digitalPinToPCMSKbit(p) (((p) <= 15) ? ((p) & 0x7) : (((p) == 16) ? (7) : (((p) <= 22) ? ((p) - 17) : ((p) - 23))))
 
+// Pin change interrupt ports, for attachPinChangeInterrupt(): the vector,
+// input register and mask register of each, numbered as their PCMSK
+#define PCINT_PORT0_VECT    PCINT0_vect
+#define PCINT_PORT0_PIN     PINB
+#define PCINT_PORT0_PCMSK   PCMSK0
+#define PCINT_PORT1_VECT    PCINT1_vect
+#define PCINT_PORT1_PIN     PINC
+#define PCINT_PORT1_PCMSK   PCMSK1
+#define PCINT_PORT2_VECT    PCINT2_vect
+#define PCINT_PORT2_PIN     PIND
+#define PCINT_PORT2_PCMSK   PCMSK2
+#define PCINT_PORT3_VECT    PCINT3_vect
+#define PCINT_PORT3_PIN     PINA
+#define PCINT_PORT3_PCMSK   PCMSK3
+
 
 #define digitalPinToInterrupt(p)  ((p) == 2 ? 0 : ((p)==3?1: NOT_AN_INTERRUPT))
 
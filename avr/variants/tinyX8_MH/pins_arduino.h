@@ -136,6 +136,21 @@ static const uint8_t A7 = 0x80 | 7;
 #define digitalPinToPCMSK(p)    ( ((p) <= 7) ? (&PCMSK2) : ( ((p) <= 14) ? (&PCMSK0) : ( ((p) <= 18) ? (&PCMSK3) : (&PCMSK1) ) ) )
 #define digitalPinToPCMSKbit(p) ( ((p) <= 7) ? (p) : (((p) <= 13) ? ((p) - 8) : (((p) == 14) ? 7 : (((p) <= 16) ? ((p) - 14) : (((p) <= 18) ? ((p) - 17) : (((p) == 25) ? 7 : ((p) - 19) ) ) ) ) ) )
 
+// Pin change interrupt ports, for attachPinChangeInterrupt(): the vector,
+// input register and mask register of each, numbered as their PCMSK
+#define PCINT_PORT0_VECT    PCINT0_vect
+#define PCINT_PORT0_PIN     PINB
+#define PCINT_PORT0_PCMSK   PCMSK0
+#define PCINT_PORT1_VECT    PCINT1_vect
+#define PCINT_PORT1_PIN     PINC
+#define PCINT_PORT1_PCMSK   PCMSK1
+#define PCINT_PORT2_VECT    PCINT2_vect
+#define PCINT_PORT2_PIN     PIND
+#define PCINT_PORT2_PCMSK   PCMSK2
+#define PCINT_PORT3_VECT    PCINT3_vect
+#define PCINT_PORT3_PIN     PINA
+#define PCINT_PORT3_PCMSK   PCMSK3
+
 #define digitalPinToInterrupt(p)  ((p) == 2 ? 0 : ((p)==3?1: NOT_AN_INTERRUPT))
 
 #ifdef ARDUINO_MAIN